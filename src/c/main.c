@@ -1,15 +1,38 @@
 #include <pebble.h>
 
 #include "modules/app_message.h"
+#include "modules/launch_cache.h"
+#include "modules/request_queue.h"
+#include "modules/trace.h"
 #include "windows/loading_window.h"
 
+// Aplite only has 24 KB of heap for everything, the others have room for
+// more departures per message
+#if defined(PBL_PLATFORM_APLITE)
+#define INBOX_SIZE_BUDGET 4096
+#else
+#define INBOX_SIZE_BUDGET 8192
+#endif
+
 static void init() {
+  trace_init();
   //no_internet_window_push();
-  loading_window_push();
+  // Show what we had last time right away, the phone refreshes it in the background
+  if (!launch_cache_show()) {
+    loading_window_push();
+  }
   app_message_register_inbox_received(inbox_received_callback);
   app_message_register_inbox_dropped(inbox_dropped_callback);
+  app_message_register_outbox_sent(outbox_sent_callback);
   app_message_register_outbox_failed(outbox_failed_callback);
-  app_message_open(4096, 256); // Inbox could be large, but outbox is pretty much only requests
+  // Inbox as big as the platform allows within our heap budget, the phone packs
+  // its messages to fit. Outbox is pretty much only requests
+  uint32_t inbox_size = app_message_inbox_size_maximum();
+  if (inbox_size > INBOX_SIZE_BUDGET) {
+    inbox_size = INBOX_SIZE_BUDGET;
+  }
+  app_message_open(inbox_size, 256);
+  request_queue_set_inbox_size(inbox_size);
   
 }
 
@@ -4,28 +4,104 @@
 #include "../windows/station_window.h"
 #include "../windows/loading_window.h"
 #include "../windows/more_info_window.h"
+#include "launch_cache.h"
+#include "request_queue.h"
+#include "trace.h"
+
+// The first list or board of a session is what the next launch starts with
+static bool s_launch_cached = false;
+
+static int find_int(DictionaryIterator *iter, uint32_t key) {
+    Tuple *tuple = dict_find(iter, key);
+    return tuple ? tuple->value->int32 : 0;
+}
+
+// Called once the payload is on screen, the cache writes it after that
+static void cache_launch_payload(DictionaryIterator *iter, uint32_t key, Tuple *tuple) {
+    if (!s_launch_cached) {
+        launch_cache_save(key, tuple, find_int(iter, MESSAGE_KEY_STATION_ID),
+                          find_int(iter, MESSAGE_KEY_REFRESH_INTERVAL));
+        s_launch_cached = true;
+    }
+}
+
+// Boards come in chunks: the first one (CHUNK_INDEX 0) replaces the board and
+// announces its total size, every following one is appended to it
+static void show_board(DictionaryIterator *iter, Tuple *board_tuple) {
+    int chunk_index = find_int(iter, MESSAGE_KEY_CHUNK_INDEX);
+    int request_id = find_int(iter, MESSAGE_KEY_REQUEST_ID);
+    if (chunk_index > 0) {
+        station_window_append_station(board_tuple, chunk_index, request_id);
+        return;
+    }
+    if (find_int(iter, MESSAGE_KEY_BOARD_PRELOAD)) {
+        station_window_preload(board_tuple, find_int(iter, MESSAGE_KEY_BOARD_ROWS),
+                               find_int(iter, MESSAGE_KEY_STATION_ID), find_int(iter, MESSAGE_KEY_REFRESH_INTERVAL));
+        return;
+    }
+    // A refresh the phone had to send in full never pushes, the user may have moved on
+    if (find_int(iter, MESSAGE_KEY_BOARD_UPDATE)) {
+        station_window_update_station(board_tuple, find_int(iter, MESSAGE_KEY_BOARD_ROWS),
+                                      find_int(iter, MESSAGE_KEY_STATION_ID), request_id);
+        return;
+    }
+    // A board for the station on screen updates it in place, anything else is pushed over it
+    station_window_set_station(board_tuple, find_int(iter, MESSAGE_KEY_BOARD_ROWS),
+                               find_int(iter, MESSAGE_KEY_STATION_ID), request_id);
+    station_window_set_refresh(find_int(iter, MESSAGE_KEY_REFRESH_INTERVAL));
+    station_window_push();
+}
+
+// The rest of a board we started showing, or a refresh of one. The phone
+// already counts on the watch having these rows, so they are never stale.
+static bool continues_board(DictionaryIterator *iter) {
+    return find_int(iter, MESSAGE_KEY_CHUNK_INDEX) > 0 || dict_find(iter, MESSAGE_KEY_STATION_DELTA) ||
+           find_int(iter, MESSAGE_KEY_BOARD_UPDATE);
+}
 
 void inbox_received_callback(DictionaryIterator *iter, void *context) {
+    // An answer to a request the user has moved on from
+    int request_id = find_int(iter, MESSAGE_KEY_REQUEST_ID);
+    trace_event(TRACE_INBOX_RECEIVED, request_id);
+    if (!request_queue_is_current(request_id) && !continues_board(iter)) {
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "Ignoring answer to request %d", request_id);
+        // The phone diffs the next refresh of this station against the rows we drop
+        Tuple *station_id_tuple = dict_find(iter, MESSAGE_KEY_STATION_ID);
+        if (station_id_tuple) {
+            station_window_forget_station(station_id_tuple->value->int32);
+        }
+        return;
+    }
+
     Tuple *no_internet_tuple = dict_find(iter, MESSAGE_KEY_NO_INTERNET);
     if (no_internet_tuple) {
         no_internet_window_push();
     }
+    Tuple *no_location_tuple = dict_find(iter, MESSAGE_KEY_NO_LOCATION);
+    if (no_location_tuple) {
+        no_internet_window_push_message("Kein Standort :(");
+    }
 
     Tuple *stations_tuple = dict_find(iter, MESSAGE_KEY_STATIONS_ARRAY);
     if (stations_tuple) {
         station_list_window_set_stations(stations_tuple);
         station_list_window_push();
+        cache_launch_payload(iter, MESSAGE_KEY_STATIONS_ARRAY, stations_tuple);
     }
 
     Tuple *station_tuple = dict_find(iter, MESSAGE_KEY_STATION_ARRAY);
     if (station_tuple) {
-        station_window_reset_if_existing();
-        station_window_set_station(station_tuple);
-        station_window_push();
+        show_board(iter, station_tuple);
+        if (find_int(iter, MESSAGE_KEY_CHUNK_INDEX) == 0) {
+            cache_launch_payload(iter, MESSAGE_KEY_STATION_ARRAY, station_tuple);
+        }
+    }
+    Tuple *station_delta_tuple = dict_find(iter, MESSAGE_KEY_STATION_DELTA);
+    if (station_delta_tuple) {
+        station_window_apply_delta(station_delta_tuple, find_int(iter, MESSAGE_KEY_STATION_ID));
     }
     Tuple *more_info_tuple = dict_find(iter, MESSAGE_KEY_MORE_INFO);
-    if (more_info_tuple) {;
-        more_info_window_reset_if_existing();
+    if (more_info_tuple) {
         more_info_window_set_info(more_info_tuple);
         more_info_window_push();
     }
@@ -33,24 +109,10 @@ void inbox_received_callback(DictionaryIterator *iter, void *context) {
     if (stops_more_info_tuple) {
         more_info_window_set_stops_more_info(stops_more_info_tuple);
     }
-    Tuple *more_info_timeout_tuple = dict_find(iter, MESSAGE_KEY_MORE_INFO_TIMEOUT);
-    if (more_info_timeout_tuple) {
-        //if we hit a more info timeout, we need to go back to the station window
-        //because the train uuid is no longer valid
-        //but we actually want to refresh the data first. MORE_INFO_TIMEOUT contains the station ID
-        int station_id = more_info_timeout_tuple->value->int32;
-        DictionaryIterator *iter2;
-        app_message_outbox_begin(&iter2);
-        dict_write_int(iter2, MESSAGE_KEY_GET_STATION, &station_id, sizeof(int), true);
-        app_message_outbox_send();
-    }
     Tuple *station_from_stop_tuple = dict_find(iter, MESSAGE_KEY_STATION_FROM_STOP);
     if (station_from_stop_tuple) {
-        //if we hit a station from stop, we want to go back to the station window
-        //but we also want to delete the more info window
-        station_window_reset_if_existing();
-        station_window_set_station(station_from_stop_tuple);
-        station_window_push();        
+        //the stop's board goes on top of the trip, Back returns to it
+        show_board(iter, station_from_stop_tuple);
     }
 }
   
@@ -59,7 +121,15 @@ void inbox_dropped_callback(AppMessageResult reason, void *context) {
   APP_LOG(APP_LOG_LEVEL_ERROR, "Message dropped. Reason: %d", (int)reason);
 }
 
+void outbox_sent_callback(DictionaryIterator *iter, void *context) {
+  request_queue_outbox_sent();
+  if (dict_find(iter, MESSAGE_KEY_TRACE_DUMP)) {
+    trace_send_next();
+  }
+}
+
 void outbox_failed_callback(DictionaryIterator *iter, AppMessageResult reason, void *context) {
-  // The message just sent failed to be delivered
+  // The message just sent failed to be delivered, the queue decides whether to retry
   APP_LOG(APP_LOG_LEVEL_ERROR, "Message send failed. Reason: %d", (int)reason);
+  request_queue_outbox_failed(reason);
 }
\ No newline at end of file
@@ -4,4 +4,5 @@
 
 void inbox_received_callback(DictionaryIterator *iterator, void *context);
 void inbox_dropped_callback(AppMessageResult reason, void *context);
+void outbox_sent_callback(DictionaryIterator *iterator, void *context);
 void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context);
\ No newline at end of file
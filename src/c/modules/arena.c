@@ -0,0 +1,106 @@
+#include "arena.h"
+
+// Everything handed out is aligned for ints and pointers
+#define ARENA_ALIGN(size) (((size) + 3) & ~((size_t)3))
+// Smallest block we add when the first one runs out
+#define ARENA_OVERFLOW_SIZE 512
+
+// The first block is the arena itself. It is sized up front from the
+// payload, overflow blocks are only chained on when a board grows
+// (more chunks than announced, updated rows).
+struct Arena {
+  Arena *next;
+  size_t size;
+  size_t used;
+  uint8_t data[];
+};
+
+static size_t s_heap_peak = 0;
+
+Arena *arena_create(size_t size) {
+  size = ARENA_ALIGN(size);
+  Arena *arena = malloc(sizeof(Arena) + size);
+  if (!arena) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Could not allocate arena of %d bytes", (int)size);
+    return NULL;
+  }
+  arena->next = NULL;
+  arena->size = size;
+  arena->used = 0;
+  return arena;
+}
+
+// Resets the arena if it is big enough for the next payload, otherwise
+// replaces it. Keeps the heap from fragmenting across refreshes.
+Arena *arena_reuse_or_create(Arena *arena, size_t size) {
+  if (arena && arena->size >= ARENA_ALIGN(size)) {
+    arena_reset(arena);
+    return arena;
+  }
+  arena_destroy(arena);
+  return arena_create(size);
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+  if (!arena) {
+    return NULL;
+  }
+  size = ARENA_ALIGN(size);
+  Arena *block = arena;
+  while (block->size - block->used < size) {
+    if (!block->next) {
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "Arena full, adding a block for %d bytes", (int)size);
+      block->next = arena_create(size > ARENA_OVERFLOW_SIZE ? size : ARENA_OVERFLOW_SIZE);
+      if (!block->next) {
+        return NULL;
+      }
+    }
+    block = block->next;
+  }
+  void *ptr = block->data + block->used;
+  block->used += size;
+  return ptr;
+}
+
+char *arena_strdup(Arena *arena, const char *str) {
+  size_t size = strlen(str) + 1;
+  char *copy = arena_alloc(arena, size);
+  if (copy) {
+    memcpy(copy, str, size);
+  }
+  return copy;
+}
+
+void arena_reset(Arena *arena) {
+  if (arena) {
+    arena_destroy(arena->next);
+    arena->next = NULL;
+    arena->used = 0;
+  }
+}
+
+void arena_destroy(Arena *arena) {
+  while (arena) {
+    Arena *next = arena->next;
+    free(arena);
+    arena = next;
+  }
+}
+
+size_t arena_used(const Arena *arena) {
+  size_t used = 0;
+  for (; arena; arena = arena->next) {
+    used += arena->used;
+  }
+  return used;
+}
+
+// Logs the current heap usage and the highest we have seen so far
+void arena_log_heap(const char *label) {
+  size_t used = heap_bytes_used();
+  if (used > s_heap_peak) {
+    s_heap_peak = used;
+  }
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "%s: heap used %d, peak %d, free %d",
+          label, (int)used, (int)s_heap_peak, (int)heap_bytes_free());
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <pebble.h>
+
+// Bump allocator for everything a window builds from one payload.
+// All strings and rows live in a single heap block that is reset as a
+// whole on refresh instead of freeing every field on its own.
+typedef struct Arena Arena;
+
+Arena *arena_create(size_t size);
+Arena *arena_reuse_or_create(Arena *arena, size_t size);
+void *arena_alloc(Arena *arena, size_t size);
+char *arena_strdup(Arena *arena, const char *str);
+void arena_reset(Arena *arena);
+void arena_destroy(Arena *arena);
+size_t arena_used(const Arena *arena);
+void arena_log_heap(const char *label);
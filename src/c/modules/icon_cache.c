@@ -0,0 +1,134 @@
+#include "icon_cache.h"
+
+#define ICON_CACHE_SIZE 8
+// Below this, icons nobody holds are freed instead of kept for later
+#define ICON_CACHE_MIN_FREE_HEAP 4096
+
+typedef struct {
+  uint32_t resource_id;
+  // 0 for the icon as it is in the resource
+  int16_t size;
+  uint16_t refs;
+  GDrawCommandImage *image;
+} IconCacheEntry;
+
+static IconCacheEntry s_entries[ICON_CACHE_SIZE];
+
+typedef struct {
+  int16_t num;
+  int16_t den;
+} Scale;
+
+static int16_t scale_value(int16_t value, const Scale *scale) {
+  return value * scale->num / scale->den;
+}
+
+static bool scale_command(GDrawCommand *command, uint32_t index, void *context) {
+  const Scale *scale = context;
+  for (uint16_t i = 0; i < gdraw_command_get_num_points(command); i++) {
+    GPoint point = gdraw_command_get_point(command, i);
+    gdraw_command_set_point(command, i, GPoint(scale_value(point.x, scale), scale_value(point.y, scale)));
+  }
+  if (gdraw_command_get_type(command) == GDrawCommandTypeCircle) {
+    gdraw_command_set_radius(command, scale_value(gdraw_command_get_radius(command), scale));
+  }
+  uint8_t stroke_width = gdraw_command_get_stroke_width(command);
+  if (stroke_width > 0) {
+    int16_t scaled = scale_value(stroke_width, scale);
+    gdraw_command_set_stroke_width(command, scaled > 0 ? scaled : 1);
+  }
+  return true;
+}
+
+// Scales the points of the image in place, there is no API to draw it smaller
+static void scale_image(GDrawCommandImage *image, int16_t size) {
+  GSize bounds = gdraw_command_image_get_bounds_size(image);
+  Scale scale = { .num = size, .den = bounds.w > bounds.h ? bounds.w : bounds.h };
+  if (scale.den <= size) {
+    return;
+  }
+  gdraw_command_list_iterate(gdraw_command_image_get_command_list(image), scale_command, &scale);
+  gdraw_command_image_set_bounds_size(image, GSize(scale_value(bounds.w, &scale), scale_value(bounds.h, &scale)));
+}
+
+static void free_entry(IconCacheEntry *entry) {
+  gdraw_command_image_destroy(entry->image);
+  entry->image = NULL;
+  entry->refs = 0;
+}
+
+void icon_cache_trim() {
+  for (int i = 0; i < ICON_CACHE_SIZE; i++) {
+    if (s_entries[i].image && s_entries[i].refs == 0) {
+      free_entry(&s_entries[i]);
+    }
+  }
+}
+
+GDrawCommandImage *icon_cache_get_scaled(uint32_t resource_id, int16_t size) {
+  IconCacheEntry *free_slot = NULL;
+  for (int i = 0; i < ICON_CACHE_SIZE; i++) {
+    IconCacheEntry *entry = &s_entries[i];
+    if (entry->image && entry->resource_id == resource_id && entry->size == size) {
+      entry->refs++;
+      return entry->image;
+    }
+    if (!entry->image && !free_slot) {
+      free_slot = entry;
+    }
+  }
+
+  if (heap_bytes_free() < ICON_CACHE_MIN_FREE_HEAP) {
+    icon_cache_trim();
+  }
+  if (!free_slot) {
+    // Every slot holds an icon, make room among the ones nobody holds
+    icon_cache_trim();
+    for (int i = 0; i < ICON_CACHE_SIZE && !free_slot; i++) {
+      if (!s_entries[i].image) {
+        free_slot = &s_entries[i];
+      }
+    }
+    if (!free_slot) {
+      APP_LOG(APP_LOG_LEVEL_ERROR, "Icon cache full");
+      return NULL;
+    }
+  }
+
+  GDrawCommandImage *image = gdraw_command_image_create_with_resource(resource_id);
+  if (!image) {
+    return NULL;
+  }
+  if (size > 0) {
+    scale_image(image, size);
+  }
+  *free_slot = (IconCacheEntry) {
+    .resource_id = resource_id,
+    .size = size,
+    .refs = 1,
+    .image = image,
+  };
+  return image;
+}
+
+GDrawCommandImage *icon_cache_get(uint32_t resource_id) {
+  return icon_cache_get_scaled(resource_id, 0);
+}
+
+void icon_cache_release(GDrawCommandImage *image) {
+  if (!image) {
+    return;
+  }
+  for (int i = 0; i < ICON_CACHE_SIZE; i++) {
+    IconCacheEntry *entry = &s_entries[i];
+    if (entry->image == image) {
+      if (entry->refs > 0) {
+        entry->refs--;
+      }
+      if (entry->refs == 0 && heap_bytes_free() < ICON_CACHE_MIN_FREE_HEAP) {
+        free_entry(entry);
+      }
+      return;
+    }
+  }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <pebble.h>
+
+// Vector icons shared by every window that draws them. Each resource is
+// loaded once and handed out with a reference count, icons nobody holds
+// any more stay around for the next window until the heap runs low.
+GDrawCommandImage *icon_cache_get(uint32_t resource_id);
+// The icon scaled down once to fit a size x size box, e.g. for menu rows
+GDrawCommandImage *icon_cache_get_scaled(uint32_t resource_id, int16_t size);
+void icon_cache_release(GDrawCommandImage *image);
+// Frees every icon nobody holds
+void icon_cache_trim();
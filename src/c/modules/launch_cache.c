@@ -0,0 +1,123 @@
+#include "launch_cache.h"
+#include "payload.h"
+#include "../windows/station_list_window.h"
+#include "../windows/station_window.h"
+
+// Bump this whenever the payload format of a cached message changes
+#define LAUNCH_CACHE_VERSION 4
+#define PERSIST_KEY_LAUNCH_HEADER 1
+#define PERSIST_KEY_LAUNCH_DATA 2
+#define LAUNCH_CACHE_CHUNKS 8
+// Persistent storage is 4 KB per app and 256 bytes per key
+#define LAUNCH_CACHE_MAX_LENGTH (LAUNCH_CACHE_CHUNKS * PERSIST_DATA_MAX_LENGTH)
+
+typedef struct {
+  uint8_t version;
+  uint8_t is_board;
+  uint16_t length;
+  int32_t fetched_at;
+  // What the board needs to refresh itself, 0 for the station list
+  int32_t station_id;
+  int32_t refresh_interval;
+} LaunchCacheHeader;
+
+// The rows waiting to be written, see launch_cache_save()
+static LaunchCacheHeader s_pending_header;
+static uint8_t *s_pending_data = NULL;
+static AppTimer *s_pending_timer = NULL;
+
+static void write_timer_callback(void *context) {
+  s_pending_timer = NULL;
+  for (int offset = 0; offset < s_pending_header.length; offset += PERSIST_DATA_MAX_LENGTH) {
+    int chunk_length = s_pending_header.length - offset < PERSIST_DATA_MAX_LENGTH ?
+                       s_pending_header.length - offset : PERSIST_DATA_MAX_LENGTH;
+    persist_write_data(PERSIST_KEY_LAUNCH_DATA + offset / PERSIST_DATA_MAX_LENGTH, s_pending_data + offset, chunk_length);
+  }
+  persist_write_data(PERSIST_KEY_LAUNCH_HEADER, &s_pending_header, sizeof(s_pending_header));
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Cached %d rows (%d bytes) for next launch", s_pending_data[0], s_pending_header.length);
+  free(s_pending_data);
+  s_pending_data = NULL;
+}
+
+// Only copies the rows, they are written once the screen they came with is
+// up: the flash writes take longer than drawing it
+void launch_cache_save(uint32_t key, Tuple *tuple, int32_t station_id, int refresh_interval) {
+  if (!tuple || tuple->type != TUPLE_BYTE_ARRAY || tuple->length == 0) {
+    return;
+  }
+  bool is_board = (key == MESSAGE_KEY_STATION_ARRAY);
+  // Only keep whole rows, big boards just lose their last departures
+  uint8_t rows = 0;
+  uint16_t length = payload_fit_rows(tuple->value->data, tuple->length,
+                                     is_board ? STATION_ROW_FORMAT : STATIONS_ROW_FORMAT,
+                                     LAUNCH_CACHE_MAX_LENGTH, &rows);
+
+  uint8_t *data = malloc(length);
+  if (!data) {
+    return;
+  }
+  memcpy(data, tuple->value->data, length);
+  // The count byte has to match the rows we actually kept
+  data[0] = rows;
+
+  if (s_pending_timer) {
+    app_timer_cancel(s_pending_timer);
+  }
+  free(s_pending_data);
+  s_pending_data = data;
+  s_pending_header = (LaunchCacheHeader) {
+    .version = LAUNCH_CACHE_VERSION,
+    .is_board = is_board,
+    .length = length,
+    .fetched_at = time(NULL),
+    .station_id = station_id,
+    .refresh_interval = refresh_interval,
+  };
+  s_pending_timer = app_timer_register(0, write_timer_callback, NULL);
+}
+
+bool launch_cache_show() {
+  LaunchCacheHeader header;
+  if (persist_read_data(PERSIST_KEY_LAUNCH_HEADER, &header, sizeof(header)) != sizeof(header) ||
+      header.version != LAUNCH_CACHE_VERSION || header.length == 0 || header.length > LAUNCH_CACHE_MAX_LENGTH) {
+    return false;
+  }
+
+  // The windows parse tuples, so rebuild one around the cached payload
+  Tuple *tuple = malloc(sizeof(Tuple) + header.length);
+  if (!tuple) {
+    return false;
+  }
+  tuple->type = TUPLE_BYTE_ARRAY;
+  tuple->length = header.length;
+  for (int offset = 0; offset < header.length; offset += PERSIST_DATA_MAX_LENGTH) {
+    int chunk_length = header.length - offset < PERSIST_DATA_MAX_LENGTH ? header.length - offset : PERSIST_DATA_MAX_LENGTH;
+    if (persist_read_data(PERSIST_KEY_LAUNCH_DATA + offset / PERSIST_DATA_MAX_LENGTH,
+                          tuple->value->data + offset, chunk_length) != chunk_length) {
+      free(tuple);
+      return false;
+    }
+  }
+
+  if (header.is_board) {
+    station_window_set_station(tuple, 0, header.station_id, 0);
+    // The phone has none of these rows yet, its first refresh has to be whole
+    station_window_forget_station(header.station_id);
+    station_window_set_stale(header.fetched_at);
+    station_window_set_refresh(header.refresh_interval);
+    station_window_push();
+  } else {
+    station_list_window_set_stations(tuple);
+    station_list_window_set_stale(header.fetched_at);
+    station_list_window_push();
+  }
+  free(tuple);
+  return true;
+}
+
+// Header text for a screen shown from the cache, e.g. "Stand: 12:34"
+void launch_cache_format_stale(char *buffer, size_t size, time_t fetched_at) {
+  char time_text[8];
+  strftime(time_text, sizeof(time_text), clock_is_24h_style() ? "%H:%M" : "%I:%M", localtime(&fetched_at));
+  snprintf(buffer, size, "Stand: %s", time_text);
+}
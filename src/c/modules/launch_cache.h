@@ -0,0 +1,11 @@
+#pragma once
+
+#include <pebble.h>
+
+// Keeps the first screen of the last session (station list or board) in
+// persistent storage, so the next launch can show it right away while the
+// phone fetches fresh data in the background. station_id and
+// refresh_interval let a cached board refresh itself, 0 for the list.
+void launch_cache_save(uint32_t key, Tuple *tuple, int32_t station_id, int refresh_interval);
+bool launch_cache_show();
+void launch_cache_format_stale(char *buffer, size_t size, time_t fetched_at);
@@ -0,0 +1,56 @@
+#include "nav_stack.h"
+#include "icon_cache.h"
+#include "../windows/loading_window.h"
+
+// Aplite has to share 24 KB between all of them and the inbox
+#if defined(PBL_PLATFORM_APLITE)
+#define NAV_STACK_MAX_WINDOWS 3
+#else
+#define NAV_STACK_MAX_WINDOWS 6
+#endif
+// Below this a new screen first makes room by dropping the oldest one
+#define NAV_STACK_MIN_FREE_HEAP 4096
+
+// Oldest first
+static Window *s_windows[NAV_STACK_MAX_WINDOWS];
+static int s_count = 0;
+
+void nav_stack_remove(Window *window) {
+  for (int i = 0; i < s_count; i++) {
+    if (s_windows[i] == window) {
+      memmove(&s_windows[i], &s_windows[i + 1], (s_count - i - 1) * sizeof(Window *));
+      s_count--;
+      return;
+    }
+  }
+}
+
+void nav_stack_make_room() {
+  // Icons nobody draws right now are cheaper to give up than a screen
+  if (heap_bytes_free() < NAV_STACK_MIN_FREE_HEAP) {
+    icon_cache_trim();
+  }
+  while (s_count > 0 && (s_count >= NAV_STACK_MAX_WINDOWS || heap_bytes_free() < NAV_STACK_MIN_FREE_HEAP)) {
+    Window *oldest = s_windows[0];
+    // Never the screen the user is looking at
+    if (oldest == window_stack_get_top_window()) {
+      return;
+    }
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Dropping oldest screen, %d retained, %d bytes free", s_count, (int)heap_bytes_free());
+    // Unloading it calls nav_stack_remove()
+    window_stack_remove(oldest, false);
+    if (s_count > 0 && s_windows[0] == oldest) {
+      nav_stack_remove(oldest);
+    }
+  }
+}
+
+void nav_stack_push(Window *window) {
+  // The spinner was only there until this screen arrived, Back skips it
+  loading_window_remove();
+  nav_stack_make_room();
+  window_stack_push(window, true);
+  if (s_count < NAV_STACK_MAX_WINDOWS) {
+    s_windows[s_count++] = window;
+  }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <pebble.h>
+
+// Boards and trip details stay on the window stack when something is pushed
+// over them, so Back shows them again as they were without asking the phone.
+// Every one of them is pushed and unloaded through here. The oldest is
+// dropped once there are too many or the heap runs low.
+void nav_stack_push(Window *window);
+// Call before allocating a new screen, may unload the oldest retained one
+void nav_stack_make_room();
+// From the window's unload handler
+void nav_stack_remove(Window *window);
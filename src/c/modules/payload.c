@@ -0,0 +1,105 @@
+#include "payload.h"
+
+void payload_reader_init(PayloadReader *reader, uint8_t *data, uint16_t length) {
+  reader->ptr = data;
+  reader->end = data + length;
+  reader->error = (data == NULL);
+}
+
+// Reads straight from the inbox buffer, which is only valid during the callback
+bool payload_reader_init_tuple(PayloadReader *reader, Tuple *tuple) {
+  if (!tuple || tuple->type != TUPLE_BYTE_ARRAY || tuple->length == 0) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Payload is missing or not a byte array");
+    payload_reader_init(reader, NULL, 0);
+    return false;
+  }
+  payload_reader_init(reader, tuple->value->data, tuple->length);
+  return true;
+}
+
+uint16_t payload_reader_remaining(const PayloadReader *reader) {
+  return reader->error ? 0 : reader->end - reader->ptr;
+}
+
+// Moves the rest of the payload to dest (at least payload_reader_remaining()
+// bytes) and continues reading there, so strings can be kept in place
+void payload_reader_copy_to(PayloadReader *reader, uint8_t *dest) {
+  if (!dest) {
+    reader->error = true;
+    return;
+  }
+  uint16_t remaining = payload_reader_remaining(reader);
+  memcpy(dest, reader->ptr, remaining);
+  payload_reader_init(reader, dest, remaining);
+}
+
+uint8_t payload_read_uint8(PayloadReader *reader) {
+  if (reader->error || reader->ptr >= reader->end) {
+    reader->error = true;
+    return 0;
+  }
+  return *reader->ptr++;
+}
+
+int32_t payload_read_int32(PayloadReader *reader) {
+  if (reader->error || reader->end - reader->ptr < 4) {
+    reader->error = true;
+    return 0;
+  }
+  const uint8_t *p = reader->ptr;
+  reader->ptr += 4;
+  return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+// Returns the string in place, or NULL if it would run past the end of the payload
+char *payload_read_string(PayloadReader *reader) {
+  uint8_t len = payload_read_uint8(reader);
+  if (reader->error || reader->end - reader->ptr <= len || reader->ptr[len] != '\0') {
+    reader->error = true;
+    return NULL;
+  }
+  char *str = (char *)reader->ptr;
+  reader->ptr += len + 1;
+  return str;
+}
+
+// Like strncpy into a fixed buffer, but always terminated and never cuts
+// a multi byte UTF-8 character (ä, ö, ü, ß...) in half
+void payload_copy_string(char *dest, size_t size, const char *src) {
+  size_t len = strlen(src);
+  if (len >= size) {
+    len = size - 1;
+    while (len > 0 && ((uint8_t)src[len] & 0xC0) == 0x80) {
+      len--;
+    }
+  }
+  memcpy(dest, src, len);
+  dest[len] = '\0';
+}
+
+// Finds the longest run of whole rows that fits in max_length bytes (count
+// byte included). row_format has one letter per field, 's' for a string
+// and 'i' for an int32. Returns the length and sets rows to the row count.
+uint16_t payload_fit_rows(uint8_t *data, uint16_t length, const char *row_format, uint16_t max_length, uint8_t *rows) {
+  PayloadReader reader;
+  payload_reader_init(&reader, data, length);
+  int count = payload_read_uint8(&reader);
+  uint16_t fit_length = 1;
+  *rows = 0;
+  while (*rows < count) {
+    for (const char *field = row_format; *field; field++) {
+      if (*field == 'i') {
+        payload_read_int32(&reader);
+      } else {
+        payload_read_string(&reader);
+      }
+    }
+    uint16_t row_end = reader.ptr - data;
+    if (reader.error || row_end > max_length) {
+      break;
+    }
+    fit_length = row_end;
+    (*rows)++;
+  }
+  return fit_length;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <pebble.h>
+
+// Cursor over a packed payload sent by the phone:
+// [row count] followed by the fields of every row, where strings are
+// [length][UTF-8 bytes][0] and numbers are little endian int32.
+typedef struct {
+  uint8_t *ptr;
+  const uint8_t *end;
+  bool error;
+} PayloadReader;
+
+void payload_reader_init(PayloadReader *reader, uint8_t *data, uint16_t length);
+bool payload_reader_init_tuple(PayloadReader *reader, Tuple *tuple);
+uint16_t payload_reader_remaining(const PayloadReader *reader);
+void payload_reader_copy_to(PayloadReader *reader, uint8_t *dest);
+uint8_t payload_read_uint8(PayloadReader *reader);
+int32_t payload_read_int32(PayloadReader *reader);
+char *payload_read_string(PayloadReader *reader);
+void payload_copy_string(char *dest, size_t size, const char *src);
+uint16_t payload_fit_rows(uint8_t *data, uint16_t length, const char *row_format, uint16_t max_length, uint8_t *rows);
@@ -0,0 +1,209 @@
+#include "request_queue.h"
+#include "trace.h"
+
+#define REQUEST_QUEUE_SIZE 4
+#define REQUEST_MAX_RETRIES 5
+#define REQUEST_RETRY_BASE_MS 100
+// Trip ids are uuids, leave some room for other formats
+#define REQUEST_TEXT_SIZE 64
+
+typedef struct {
+  int32_t id;
+  // whether the answer replaces what is on screen, see request_queue_send()
+  bool supersedes;
+  uint32_t key;
+  int32_t value;
+  // 0 if the request has no text
+  uint32_t text_key;
+  char text[REQUEST_TEXT_SIZE];
+  // sent instead of value if set, owned by the caller
+  const uint8_t *data;
+  uint16_t data_length;
+} Request;
+
+static Request s_requests[REQUEST_QUEUE_SIZE];
+static int s_num_requests = 0;
+static bool s_in_flight = false;
+static int s_retries = 0;
+static AppTimer *s_retry_timer = NULL;
+// The phone echoes the id of the request it answers in REQUEST_ID
+static int32_t s_next_id = 1;
+// Answers to anything older than this are no longer wanted
+static int32_t s_awaited_id = 0;
+// Goes with every request, so the phone knows how much it can send
+static int32_t s_inbox_size = 0;
+
+static void send_next();
+
+static void drop_first() {
+  if (s_num_requests > 0) {
+    s_num_requests--;
+    memmove(&s_requests[0], &s_requests[1], s_num_requests * sizeof(Request));
+  }
+  s_retries = 0;
+}
+
+static void retry_timer_callback(void *context) {
+  s_retry_timer = NULL;
+  send_next();
+}
+
+// Waits 100, 200, 400... ms before trying the first request again
+static void schedule_retry() {
+  if (s_retries >= REQUEST_MAX_RETRIES) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Giving up on request %d after %d tries", (int)s_requests[0].key, s_retries);
+    drop_first();
+    send_next();
+    return;
+  }
+  uint32_t delay = REQUEST_RETRY_BASE_MS << s_retries;
+  s_retries++;
+  if (!s_retry_timer) {
+    s_retry_timer = app_timer_register(delay, retry_timer_callback, NULL);
+  }
+}
+
+static void send_next() {
+  if (s_in_flight || s_retry_timer || s_num_requests == 0) {
+    return;
+  }
+  DictionaryIterator *iter;
+  AppMessageResult result = app_message_outbox_begin(&iter);
+  if (result != APP_MSG_OK) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Outbox not ready (%d), retrying", (int)result);
+    schedule_retry();
+    return;
+  }
+  if (s_requests[0].data) {
+    dict_write_data(iter, s_requests[0].key, s_requests[0].data, s_requests[0].data_length);
+  } else {
+    dict_write_int(iter, s_requests[0].key, &s_requests[0].value, sizeof(int32_t), true);
+  }
+  dict_write_int(iter, MESSAGE_KEY_REQUEST_ID, &s_requests[0].id, sizeof(int32_t), true);
+  if (s_requests[0].key != MESSAGE_KEY_INBOX_SIZE) {
+    dict_write_int(iter, MESSAGE_KEY_INBOX_SIZE, &s_inbox_size, sizeof(int32_t), true);
+  }
+  if (s_requests[0].text_key != 0) {
+    dict_write_cstring(iter, s_requests[0].text_key, s_requests[0].text);
+  }
+  result = app_message_outbox_send();
+  if (result != APP_MSG_OK) {
+    schedule_retry();
+    return;
+  }
+  s_in_flight = true;
+  trace_event(TRACE_OUTBOX_SEND, s_requests[0].key);
+}
+
+static bool same_request(const Request *a, const Request *b) {
+  return a->key == b->key && a->value == b->value && a->data == b->data &&
+         a->text_key == b->text_key && strcmp(a->text, b->text) == 0;
+}
+
+// A request the user made replaces the ones before it: those still queued
+// are dropped, and answers to those already sent are ignored when they come
+static bool enqueue(Request request) {
+  if (request.supersedes) {
+    for (int i = s_in_flight ? 1 : 0; i < s_num_requests; i++) {
+      Request *queued = &s_requests[i];
+      if (queued->supersedes && !same_request(queued, &request)) {
+        s_num_requests--;
+        memmove(queued, queued + 1, (s_num_requests - i) * sizeof(Request));
+        i--;
+      }
+    }
+  }
+  // Coalesce with an identical request that is queued or in flight. Going
+  // back to what was asked for before makes it the awaited one again, the
+  // requests made in between are gone by now.
+  for (int i = 0; i < s_num_requests; i++) {
+    Request *queued = &s_requests[i];
+    if (same_request(queued, &request)) {
+      if (request.supersedes) {
+        queued->supersedes = true;
+        s_awaited_id = queued->id;
+      }
+      return true;
+    }
+  }
+  if (s_num_requests == REQUEST_QUEUE_SIZE) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Request queue full, dropping request %d", (int)request.key);
+    return false;
+  }
+  request.id = s_next_id++;
+  if (request.supersedes) {
+    s_awaited_id = request.id;
+  }
+  s_requests[s_num_requests++] = request;
+  send_next();
+  return true;
+}
+
+// A cut off trip id would get the phone the wrong trip or none, so a text
+// that doesn't fit is not sent at all
+bool request_queue_send_text(uint32_t key, int32_t value, uint32_t text_key, const char *text) {
+  Request request = { .supersedes = true, .key = key, .value = value, .text_key = text_key };
+  if (text) {
+    if (strlen(text) >= sizeof(request.text)) {
+      APP_LOG(APP_LOG_LEVEL_ERROR, "Not sending request %d, text is %d bytes", (int)key, (int)strlen(text));
+      return false;
+    }
+    strcpy(request.text, text);
+  }
+  return enqueue(request);
+}
+
+void request_queue_send(uint32_t key, int32_t value) {
+  request_queue_send_text(key, value, 0, NULL);
+}
+
+void request_queue_send_background(uint32_t key, int32_t value) {
+  enqueue((Request) { .supersedes = false, .key = key, .value = value });
+}
+
+bool request_queue_send_data(uint32_t key, const uint8_t *data, uint16_t length) {
+  return enqueue((Request) { .supersedes = false, .key = key, .data = data, .data_length = length });
+}
+
+// Also tells the phone right away, before the first request
+void request_queue_set_inbox_size(uint32_t size) {
+  s_inbox_size = size;
+  request_queue_send_background(MESSAGE_KEY_INBOX_SIZE, size);
+}
+
+// Messages the phone sends on its own (launch, preload) have no request id
+bool request_queue_is_current(int32_t request_id) {
+  return request_id == 0 || request_id >= s_awaited_id;
+}
+
+// The user left the screen that asked for the data, so nothing that has
+// not been sent yet is needed anymore
+void request_queue_cancel() {
+  if (s_retry_timer) {
+    app_timer_cancel(s_retry_timer);
+    s_retry_timer = NULL;
+  }
+  s_num_requests = s_in_flight ? 1 : 0;
+  s_retries = 0;
+  s_awaited_id = s_next_id;
+}
+
+void request_queue_outbox_sent() {
+  s_in_flight = false;
+  drop_first();
+  send_next();
+}
+
+void request_queue_outbox_failed(AppMessageResult reason) {
+  s_in_flight = false;
+  if (s_num_requests == 0) {
+    return;
+  }
+  if (reason == APP_MSG_BUSY || reason == APP_MSG_SEND_TIMEOUT) {
+    schedule_retry();
+  } else {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Dropping request %d, reason %d", (int)s_requests[0].key, (int)reason);
+    drop_first();
+    send_next();
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <pebble.h>
+
+// All requests to the phone go through here instead of writing to the
+// outbox directly. Identical pending requests are sent once, and a busy
+// outbox or a send timeout is retried with exponential backoff.
+// Every request gets an id the phone echoes back, a new request from the
+// user makes the answers to the ones before it stale.
+void request_queue_send(uint32_t key, int32_t value);
+// Same, with a string under text_key in the same message. False if the
+// queue is full or the text is longer than a trip id can be.
+bool request_queue_send_text(uint32_t key, int32_t value, uint32_t text_key, const char *text);
+// For requests the user didn't make (refreshes), they never make others stale
+void request_queue_send_background(uint32_t key, int32_t value);
+// A byte array under key, data has to stay valid until it is sent.
+// False if the queue is full.
+bool request_queue_send_data(uint32_t key, const uint8_t *data, uint16_t length);
+bool request_queue_is_current(int32_t request_id);
+void request_queue_set_inbox_size(uint32_t size);
+void request_queue_cancel();
+void request_queue_outbox_sent();
+void request_queue_outbox_failed(AppMessageResult reason);
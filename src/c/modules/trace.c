@@ -0,0 +1,96 @@
+#include "trace.h"
+#include "request_queue.h"
+
+#define TRACE_SIZE 32
+// The outbox is small, so the buffer goes to the phone in a few messages
+#define TRACE_ROWS_PER_MESSAGE 12
+#define TRACE_FIELDS 4
+#define TRACE_MESSAGES ((TRACE_SIZE + TRACE_ROWS_PER_MESSAGE - 1) / TRACE_ROWS_PER_MESSAGE)
+
+typedef struct {
+  uint32_t ms;
+  int32_t value;
+  uint32_t heap;
+  uint8_t event;
+} TraceEntry;
+
+static TraceEntry s_entries[TRACE_SIZE];
+static int s_next = 0;
+static int s_count = 0;
+static time_t s_start_seconds = 0;
+static uint16_t s_start_ms = 0;
+// [row count] and [ms][event][value][heap] as int32 per row, like the payloads
+// the phone sends us. Has to stay put until the queue has sent it.
+static uint8_t s_dump[TRACE_MESSAGES][1 + TRACE_ROWS_PER_MESSAGE * TRACE_FIELDS * sizeof(int32_t)];
+static uint16_t s_dump_lengths[TRACE_MESSAGES];
+static int s_dump_messages = 0;
+// The next message of the dump to hand to the queue
+static int s_dump_next = 0;
+
+static uint32_t now_ms() {
+  time_t seconds;
+  uint16_t ms;
+  time_ms(&seconds, &ms);
+  return (seconds - s_start_seconds) * 1000 + ms - s_start_ms;
+}
+
+void trace_init() {
+  time_ms(&s_start_seconds, &s_start_ms);
+}
+
+void trace_event(TraceEvent event, int32_t value) {
+  s_entries[s_next] = (TraceEntry) {
+    .ms = now_ms(),
+    .value = value,
+    .heap = heap_bytes_used(),
+    .event = event,
+  };
+  s_next = (s_next + 1) % TRACE_SIZE;
+  if (s_count < TRACE_SIZE) {
+    s_count++;
+  }
+}
+
+static uint8_t *write_int32(uint8_t *ptr, int32_t value) {
+  for (int i = 0; i < 4; i++) {
+    *ptr++ = (value >> (i * 8)) & 0xFF;
+  }
+  return ptr;
+}
+
+// The messages go to the queue one at a time, each once the one before is
+// sent, so a dump never takes the queue's room from the requests
+void trace_send_next() {
+  if (s_dump_next >= s_dump_messages) {
+    return;
+  }
+  int message = s_dump_next++;
+  if (!request_queue_send_data(MESSAGE_KEY_TRACE_DUMP, s_dump[message], s_dump_lengths[message])) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Trace dump dropped after %d of %d messages", message, s_dump_messages);
+    s_dump_next = s_dump_messages;
+  }
+}
+
+// Oldest event first. A dump still being sent is replaced.
+void trace_send() {
+  int first = (s_next - s_count + TRACE_SIZE) % TRACE_SIZE;
+  int count = s_count;
+  s_dump_messages = 0;
+  s_dump_next = 0;
+  for (int message = 0; count > 0; message++) {
+    int rows = count < TRACE_ROWS_PER_MESSAGE ? count : TRACE_ROWS_PER_MESSAGE;
+    uint8_t *ptr = s_dump[message];
+    *ptr++ = rows;
+    for (int i = 0; i < rows; i++) {
+      TraceEntry *entry = &s_entries[(first + message * TRACE_ROWS_PER_MESSAGE + i) % TRACE_SIZE];
+      ptr = write_int32(ptr, entry->ms);
+      ptr = write_int32(ptr, entry->event);
+      ptr = write_int32(ptr, entry->value);
+      ptr = write_int32(ptr, entry->heap);
+    }
+    s_dump_lengths[message] = ptr - s_dump[message];
+    s_dump_messages++;
+    count -= rows;
+  }
+  trace_send_next();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <pebble.h>
+
+// Timeline of what the app did last, kept in a small ring buffer. Every
+// event is stamped with the ms since launch and the heap in use, so the
+// time between a click and the board showing up can be split into stages.
+// A long press on a board sends the buffer to the phone, which prints it
+// to its log.
+typedef enum {
+  TRACE_OUTBOX_SEND,
+  TRACE_INBOX_RECEIVED,
+  TRACE_PARSE_START,
+  TRACE_PARSE_END,
+  TRACE_WINDOW_LOAD,
+  TRACE_FIRST_DRAW,
+} TraceEvent;
+
+// What TRACE_WINDOW_LOAD and TRACE_FIRST_DRAW are about
+typedef enum {
+  TRACE_WINDOW_STATION_LIST,
+  TRACE_WINDOW_STATION,
+  TRACE_WINDOW_MORE_INFO,
+} TraceWindow;
+
+void trace_init();
+void trace_event(TraceEvent event, int32_t value);
+void trace_send();
+// From the outbox sent handler, after a TRACE_DUMP message went out
+void trace_send_next();
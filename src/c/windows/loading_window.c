@@ -1,8 +1,11 @@
 #include "loading_window.h"
 #include "../windows/no_internet_window.h"
+#include "../modules/request_queue.h"
 #include <pebble.h>
 
 static Window *s_window;
+// What the spinner was pushed over
+static Window *s_covered;
 static Layer *s_loading_layer;
 static TextLayer *s_text_layer;
 static StatusBarLayer *s_status_bar;
@@ -77,11 +80,19 @@ static void animation_timer_callback(void *context) {
 
 // Timeout timer callback
 static void timeout_timer_callback(void *context) {
-  // Show no connection screen
+  s_timeout_timer = NULL;
+  // Show no connection screen, it takes the loading window's place
   no_internet_window_push();
-  
-  // Destroy the loading window
-  window_stack_remove(s_window, true);
+}
+
+// Backing out of the spinner means the user no longer wants what we asked for
+static void back_click_handler(ClickRecognizerRef recognizer, void *context) {
+  request_queue_cancel();
+  window_stack_pop(true);
+}
+
+static void click_config_provider(void *context) {
+  window_single_click_subscribe(BUTTON_ID_BACK, back_click_handler);
 }
 
 static void window_load(Window *window) {
@@ -106,6 +117,8 @@ static void window_load(Window *window) {
   
   s_animation_timer = app_timer_register(ANIMATION_DURATION, animation_timer_callback, NULL);
   s_timeout_timer = app_timer_register(TIMEOUT_DURATION, timeout_timer_callback, NULL);
+
+  window_set_click_config_provider(window, click_config_provider);
 }
 
 static void window_unload(Window *window) {
@@ -146,5 +159,23 @@ void loading_window_push() {
       .unload = window_unload,
     });
   }
+  if (window_stack_get_top_window() != s_window) {
+    s_covered = window_stack_get_top_window();
+  }
   window_stack_push(s_window, true);
-}
\ No newline at end of file
+}
+
+// The screen we were waiting for is there
+void loading_window_remove() {
+  if (s_window) {
+    window_stack_remove(s_window, false);
+  }
+}
+
+Window *loading_window_get_covered() {
+  Window *top = window_stack_get_top_window();
+  if (s_window && top == s_window) {
+    return s_covered;
+  }
+  return top;
+}
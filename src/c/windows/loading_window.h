@@ -2,4 +2,7 @@
 
 #include <pebble.h>
 
-void loading_window_push();
\ No newline at end of file
+void loading_window_push();
+void loading_window_remove();
+// The top window once the spinner is gone, the one beneath it while it is up
+Window *loading_window_get_covered();
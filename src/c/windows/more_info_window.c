@@ -1,206 +1,163 @@
 #include "more_info_window.h"
 #include "loading_window.h"
+#include "../modules/arena.h"
+#include "../modules/icon_cache.h"
+#include "../modules/nav_stack.h"
+#include "../modules/payload.h"
+#include "../modules/request_queue.h"
+#include "../modules/trace.h"
 #include <pebble.h>
 
-static Window *s_window;
-static MenuLayer *s_menu_layer;
-static StatusBarLayer *s_status_bar;
-static Layer *s_info_layer;
-static char *s_line_name = NULL;
-static char *s_destination = NULL;
-static char *s_platform = NULL;
-static char *s_time = NULL;
-static char *s_delay = NULL;
-static char *s_type = NULL;
-static int *s_stops_ids = NULL;  // Changed from char**
-static char **s_stops = NULL;
-static int s_num_stops = 0;
-
-static GDrawCommandImage *s_tram_icon = NULL;
-static GDrawCommandImage *s_train_icon = NULL;
-
-static void create_menu_layer();
-
-void free_more_info_memory() {
-  if (s_stops) {
-    for (int i = 0; i < s_num_stops; i++) {
-      free(s_stops[i]);
-    }
-    free(s_stops);
-    s_stops = NULL;
-  }
-  if (s_stops_ids) {
-    free(s_stops_ids);  // Simplified, no need to free each element
-    s_stops_ids = NULL;
-  }
+typedef struct {
+  int id;
+  char *name;
+  int16_t text_height;
+} Stop;
+
+// One trip. Like boards, trips stay alive below whatever is pushed over them
+// until they are popped or dropped by the nav stack, see nav_stack.h
+typedef struct {
+  Window *window;
+  MenuLayer *menu_layer;
+  StatusBarLayer *status_bar;
+  Layer *info_layer;
+  char *line_name;
+  char *destination;
+  char *platform;
+  char *time;
+  char *delay;
+  char *type;
+  Stop *stops;
+  int num_stops;
+  // MORE_INFO and STOPS_MORE_INFO arrive separately, each keeps its strings in its own arena
+  Arena *info_arena;
+  Arena *stops_arena;
+  // Stop name heights are measured once for one cell size instead of on every draw.
+  // Rows drawn at any other size (e.g. the focused row on round) are measured on the fly
+  GSize stops_measured_size;
+  bool stops_measured;
+  // Same for the destination on the info layer, keyed by the width it was measured for
+  int16_t destination_height;
+  int16_t destination_measured_width;
+  bool first_draw_traced;
+  GDrawCommandImage *tram_icon;
+  GDrawCommandImage *train_icon;
+  AppTimer *scroll_timer;
+  bool scrolling_up;
+} TripInfo;
+
+// The trip MORE_INFO and STOPS_MORE_INFO go to, the one pushed last
+static TripInfo *s_trip = NULL;
+static GFont s_stop_font;
+
+static void create_menu_layer(TripInfo *trip);
+static TripInfo *trip_create();
+
+// The one the buttons are pressed on
+static TripInfo *top_trip() {
+  return window_get_user_data(window_stack_get_top_window());
+}
+
+static void free_more_info_memory(TripInfo *trip) {
+  arena_destroy(trip->stops_arena);
+  trip->stops_arena = NULL;
+  trip->stops = NULL;
+  trip->num_stops = 0;
 }
 
+static void free_info_memory(TripInfo *trip) {
+  arena_destroy(trip->info_arena);
+  trip->info_arena = NULL;
+  // Point at empty strings so the info layer never draws freed memory
+  trip->line_name = "";
+  trip->destination = "";
+  trip->platform = "";
+  trip->time = "";
+  trip->delay = "";
+  trip->type = "";
+}
+
+// Every trip gets a window of its own, the one before stays where it is
 void more_info_window_set_info(Tuple *info_tuple) {
-  // Free previous allocations
-  free_more_info_memory();
-
-  // Parse the info array
-  if (info_tuple) {
-    const char *data = info_tuple->value->cstring;
-    const char *ptr = data;
-
-    // Extract the line name
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    ptr++;
-    const char *start = ptr;
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    size_t len = ptr - start;
-    s_line_name = malloc(len + 1);
-    strncpy(s_line_name, start, len);
-    s_line_name[len] = '\0';
-    ptr++;
-
-    // Extract the destination
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    ptr++;
-    start = ptr;
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    len = ptr - start;
-    s_destination = malloc(len + 1);
-    strncpy(s_destination, start, len);
-    s_destination[len] = '\0';
-    ptr++;
-
-    // Extract the platform
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    ptr++;
-    start = ptr;
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    len = ptr - start;
-    s_platform = malloc(len + 1);
-    strncpy(s_platform, start, len);
-    s_platform[len] = '\0';
-    ptr++;
-
-    // Extract the time schedule
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    ptr++;
-    start = ptr;
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    len = ptr - start;
-    s_time = malloc(len + 1);
-    strncpy(s_time, start, len);
-    s_time[len] = '\0';
-    ptr++;
-
-    // Extract the time delayed
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    ptr++;
-    start = ptr;
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    len = ptr - start;
-    s_delay = malloc(len + 1);
-    strncpy(s_delay, start, len);
-    s_delay[len] = '\0';
-    ptr++;
-
-    // Extract the type
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    ptr++;
-    start = ptr;
-    while (*ptr != '"' && *ptr != '\0') ptr++;
-    if (*ptr == '\0') return;
-    len = ptr - start;
-    s_type = malloc(len + 1);
-    strncpy(s_type, start, len);
-    s_type[len] = '\0';
-  } else {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "info_tuple is NULL");
+  TripInfo *trip = trip_create();
+  if (!trip) {
+    return;
   }
+  s_trip = trip;
+  trace_event(TRACE_PARSE_START, TRACE_WINDOW_MORE_INFO);
+
+  PayloadReader reader;
+  if (!payload_reader_init_tuple(&reader, info_tuple)) {
+    return;
+  }
+  payload_read_uint8(&reader);
+  uint16_t remaining = payload_reader_remaining(&reader);
+  trip->info_arena = arena_create(remaining);
+  payload_reader_copy_to(&reader, arena_alloc(trip->info_arena, remaining));
+
+  // A single row of line name, destination, platform, time, delay and type
+  char *line_name = payload_read_string(&reader);
+  char *destination = payload_read_string(&reader);
+  char *platform = payload_read_string(&reader);
+  char *time = payload_read_string(&reader);
+  char *delay = payload_read_string(&reader);
+  char *type = payload_read_string(&reader);
+  if (reader.error) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "More info payload truncated");
+    return;
+  }
+  trip->line_name = line_name;
+  trip->destination = destination;
+  trip->destination_measured_width = -1;
+  trip->platform = platform;
+  trip->time = time;
+  trip->delay = delay;
+  trip->type = type;
+  trace_event(TRACE_PARSE_END, 1);
 }
 
 void more_info_window_set_stops_more_info(Tuple *stops_more_info_tuple) {
-  // Free previous allocations
-  free_more_info_memory();
-
-  // Parse the stops more info array
-  if (stops_more_info_tuple) {
-    const char *data = stops_more_info_tuple->value->cstring;
-    const char *ptr = data;
-    s_num_stops = 0;
-
-    // Count the number of stops
-    while (*ptr != '\0') {
-      if (*ptr == '[') {
-        s_num_stops++;
-      }
-      ptr++;
-    }
+  TripInfo *trip = s_trip;
+  if (!trip) {
+    return;
+  }
+  trip->num_stops = 0;
+  trip->stops = NULL;
 
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "Total stops counted: %d", s_num_stops);
+  PayloadReader reader;
+  if (!payload_reader_init_tuple(&reader, stops_more_info_tuple)) {
+    return;
+  }
+  int count = payload_read_uint8(&reader);
+  trace_event(TRACE_PARSE_START, TRACE_WINDOW_MORE_INFO);
 
-    // Allocate memory for the stops
-    s_stops = malloc(s_num_stops * sizeof(char *));
-    s_stops_ids = malloc(s_num_stops * sizeof(int));  // Changed to int*
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Total stops counted: %d", count);
 
-    // Parse the stops
-    ptr = data;
-    int current_stop = 0;
-    
-    while (*ptr != '\0' && current_stop < s_num_stops) {
-      // Skip to the start of the stop ID
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      ptr++;
-
-      // Extract the stop ID as integer
-      const char *start = ptr;
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      
-      // Convert string to integer directly
-      char temp[20] = {0};  // Temporary buffer for the ID string
-      size_t len = ptr - start;
-      if (len < sizeof(temp)) {
-        strncpy(temp, start, len);
-        temp[len] = '\0';
-        s_stops_ids[current_stop] = atoi(temp);  // Convert to integer
-      }
-      ptr++;
-
-      // Skip to the start of the stop name
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      ptr++;
-
-      // Extract the stop name
-      start = ptr;
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      len = ptr - start;
-      s_stops[current_stop] = malloc(len + 1);
-      strncpy(s_stops[current_stop], start, len);
-      s_stops[current_stop][len] = '\0';
-      ptr++;
-      
-      // Increment current stop count
-      current_stop++;
-      
-      // Skip to the next stop or end
-      while (*ptr != '[' && *ptr != '\0') ptr++;
+  // The stop rows and the names they point to share one arena sized from the tuple
+  uint16_t remaining = payload_reader_remaining(&reader);
+  trip->stops_arena = arena_reuse_or_create(trip->stops_arena, count * sizeof(Stop) + remaining + sizeof(int));
+  trip->stops = arena_alloc(trip->stops_arena, count * sizeof(Stop));
+  payload_reader_copy_to(&reader, arena_alloc(trip->stops_arena, remaining));
+  if (!trip->stops) {
+    return;
+  }
+
+  // Each row is the stop ID and the stop name
+  while (trip->num_stops < count) {
+    trip->stops[trip->num_stops].id = payload_read_int32(&reader);
+    trip->stops[trip->num_stops].name = payload_read_string(&reader);
+    if (reader.error) {
+      break;
     }
+    trip->num_stops++;
+  }
+  trip->stops_measured = false;
+  trace_event(TRACE_PARSE_END, trip->num_stops);
 
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "Stops actually processed: %d", current_stop);
-    s_num_stops = current_stop;
-    create_menu_layer();
-  } else {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "stops_more_info_tuple is NULL");
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Stops actually processed: %d", trip->num_stops);
+  arena_log_heap("Stops");
+  if (!trip->menu_layer && window_is_loaded(trip->window)) {
+    create_menu_layer(trip);
   }
 }
 
@@ -209,30 +166,43 @@ static uint16_t menu_get_num_sections_callback(MenuLayer *menu_layer, void *data
 }
 
 static uint16_t menu_get_num_rows_callback(MenuLayer *menu_layer, uint16_t section_index, void *data) {
-  return s_num_stops;
+  TripInfo *trip = data;
+  return trip->num_stops;
+}
+
+static int16_t measure_stop(const Stop *stop, GSize cell_size) {
+  return graphics_text_layout_get_content_size(
+    stop->name, s_stop_font, GRect(0, 0, cell_size.w, cell_size.h), GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft
+  ).h;
+}
+
+static void measure_stops(TripInfo *trip, GSize cell_size) {
+  for (int i = 0; i < trip->num_stops; i++) {
+    trip->stops[i].text_height = measure_stop(&trip->stops[i], cell_size);
+  }
+  trip->stops_measured_size = cell_size;
+  trip->stops_measured = true;
 }
 
 static void menu_draw_row_callback(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index, void *data) {
+  TripInfo *trip = data;
   GRect bounds = layer_get_bounds(cell_layer);
-  
+  Stop *stop = &trip->stops[cell_index->row];
+
   // Calculate vertical center position
-  #if PBL_DISPLAY_HEIGHT == 228
-  GFont font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
-  #else
-  GFont font = fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD);
-  #endif
-  GSize text_size = graphics_text_layout_get_content_size(
-    s_stops[cell_index->row], font, bounds, GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft
-  );
+  if (!trip->stops_measured) {
+    measure_stops(trip, bounds.size);
+  }
+  int16_t text_height = gsize_equal(&bounds.size, &trip->stops_measured_size) ? stop->text_height : measure_stop(stop, bounds.size);
   
   // Calculate vertical offset
-  int y_offset = (bounds.size.h - text_size.h - 6) / 2;
+  int y_offset = (bounds.size.h - text_height - 6) / 2;
   
   // Create text bounds with calculated offset
   #if PBL_RECT
-  GRect text_bounds = GRect(5, y_offset, bounds.size.w - 30, text_size.h);
+  GRect text_bounds = GRect(5, y_offset, bounds.size.w - 30, text_height);
   #else
-  GRect text_bounds = GRect(5, y_offset, bounds.size.w - 10, text_size.h);
+  GRect text_bounds = GRect(5, y_offset, bounds.size.w - 10, text_height);
   #endif
 
   bool is_selected = menu_cell_layer_is_highlighted(cell_layer);
@@ -241,64 +211,62 @@ static void menu_draw_row_callback(GContext *ctx, const Layer *cell_layer, MenuI
   graphics_context_set_fill_color(ctx, is_selected ? PBL_IF_BW_ELSE(GColorBlack, GColorDarkGreen) : GColorWhite);
   graphics_fill_rect(ctx, bounds, 0, GCornerNone);
 
-  graphics_draw_text(ctx, s_stops[cell_index->row], font, 
+  graphics_draw_text(ctx, stop->name, s_stop_font,
                       text_bounds, GTextOverflowModeTrailingEllipsis, 
                       PBL_IF_RECT_ELSE(GTextAlignmentLeft, GTextAlignmentCenter), NULL);
 }
 
 static void menu_select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *data) {
-  int station_id = s_stops_ids[cell_index->row];  // No need to dereference
+  TripInfo *trip = data;
+  int station_id = trip->stops[cell_index->row].id;
   APP_LOG(APP_LOG_LEVEL_DEBUG, "Selected station ID: %d", station_id);
   // Send the station ID to the station window
-  DictionaryIterator *iter;
-  app_message_outbox_begin(&iter);
-  dict_write_int(iter, MESSAGE_KEY_GET_STATION_FROM_STOP, &station_id, sizeof(int), true);
-  app_message_outbox_send();
+  request_queue_send(MESSAGE_KEY_GET_STATION_FROM_STOP, station_id);
   // Push the loading window
   loading_window_push();
 }
 
-static void create_menu_layer() {
-  Layer *window_layer = window_get_root_layer(s_window);
+static void create_menu_layer(TripInfo *trip) {
+  Layer *window_layer = window_get_root_layer(trip->window);
   GRect bounds = layer_get_bounds(window_layer);
 
-  s_menu_layer = menu_layer_create(bounds);
-  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+  trip->menu_layer = menu_layer_create(bounds);
+  menu_layer_set_callbacks(trip->menu_layer, trip, (MenuLayerCallbacks) {
     .get_num_sections = menu_get_num_sections_callback,
     .get_num_rows = menu_get_num_rows_callback,
     .draw_row = menu_draw_row_callback,
     .select_click = menu_select_callback,
   });
-  //menu_layer_set_click_config_onto_window(s_menu_layer, s_window);
-  menu_layer_set_highlight_colors(s_menu_layer, PBL_IF_BW_ELSE(GColorBlack, GColorDarkGreen), GColorWhite);
-  layer_add_child(window_layer, menu_layer_get_layer(s_menu_layer));
-  layer_set_hidden(menu_layer_get_layer(s_menu_layer), true);
+  //menu_layer_set_click_config_onto_window(trip->menu_layer, trip->window);
+  menu_layer_set_highlight_colors(trip->menu_layer, PBL_IF_BW_ELSE(GColorBlack, GColorDarkGreen), GColorWhite);
+  layer_add_child(window_layer, menu_layer_get_layer(trip->menu_layer));
+  layer_set_hidden(menu_layer_get_layer(trip->menu_layer), true);
 }
 
 static void menu_click_config_provider(void *context);
-static void show_info();
-
-static void activate_menu() {
-  layer_set_hidden(s_info_layer, true);
-  layer_set_hidden(menu_layer_get_layer(s_menu_layer), false);
-  menu_layer_set_selected_index(s_menu_layer, (MenuIndex){.section = 0, .row = 0}, MenuRowAlignCenter, false);
-  layer_mark_dirty(menu_layer_get_layer(s_menu_layer));
-  scroll_layer_set_callbacks(menu_layer_get_scroll_layer(s_menu_layer), (ScrollLayerCallbacks){
+static void show_info(TripInfo *trip);
+
+static void activate_menu(TripInfo *trip) {
+  layer_set_hidden(trip->info_layer, true);
+  layer_set_hidden(menu_layer_get_layer(trip->menu_layer), false);
+  menu_layer_set_selected_index(trip->menu_layer, (MenuIndex){.section = 0, .row = 0}, MenuRowAlignCenter, false);
+  layer_mark_dirty(menu_layer_get_layer(trip->menu_layer));
+  scroll_layer_set_callbacks(menu_layer_get_scroll_layer(trip->menu_layer), (ScrollLayerCallbacks){
                                                                             .click_config_provider = menu_click_config_provider,
                                                                         });
-  menu_layer_set_click_config_onto_window(s_menu_layer, s_window);
+  menu_layer_set_click_config_onto_window(trip->menu_layer, trip->window);
 }
 
 // Hides the menu and unbinds the click handler
-static void deactivate_menu() {
+static void deactivate_menu(TripInfo *trip) {
   // First disable click config on the menu layer
-  if (s_menu_layer) {
+  if (trip->menu_layer) {
     // Use proper API to remove menu click config
     // Don't set to null directly - this resets click config properly
-    window_set_click_config_provider(s_window, NULL);
+    window_set_click_config_provider(trip->window, NULL);
     
     // Reset scroll layer callbacks safely
-    ScrollLayer *scroll_layer = menu_layer_get_scroll_layer(s_menu_layer);
+    ScrollLayer *scroll_layer = menu_layer_get_scroll_layer(trip->menu_layer);
     if (scroll_layer) {
       scroll_layer_set_callbacks(scroll_layer, (ScrollLayerCallbacks){
         .click_config_provider = NULL,
@@ -306,12 +274,12 @@ static void deactivate_menu() {
     }
     
     // Finally hide the menu layer
-    layer_set_hidden(menu_layer_get_layer(s_menu_layer), true);
+    layer_set_hidden(menu_layer_get_layer(trip->menu_layer), true);
   }
 }
 
 static void info_down_handler(ClickRecognizerRef recognizer, void *context) {
-  activate_menu();
+  activate_menu(top_trip());
 }
 
 static void info_click_config_provider(void *context) {
@@ -319,124 +287,129 @@ static void info_click_config_provider(void *context) {
 }
 
 static void menu_up_handler(ClickRecognizerRef recognizer, void *context) {
+  TripInfo *trip = top_trip();
   // Safety check to make sure menu layer exists and is visible
-  if (!s_menu_layer || layer_get_hidden(menu_layer_get_layer(s_menu_layer))) {
+  if (!trip->menu_layer || layer_get_hidden(menu_layer_get_layer(trip->menu_layer))) {
     return;
   }
 
-  MenuIndex index = menu_layer_get_selected_index(s_menu_layer);
+  MenuIndex index = menu_layer_get_selected_index(trip->menu_layer);
   if (index.row == 0) {
     // Don't call menu_layer_set_click_config_onto_window with NULL - this causes the fault
     // Instead, let deactivate_menu handle click config properly
-    deactivate_menu();
-    show_info();
+    deactivate_menu(trip);
+    show_info(trip);
     return;
   }
 
   // Set next selection with safety bounds check
-  menu_layer_set_selected_next(s_menu_layer, true, MenuRowAlignCenter, true);
+  menu_layer_set_selected_next(trip->menu_layer, true, MenuRowAlignCenter, true);
 }
 
 static void menu_down_handler(ClickRecognizerRef recognizer, void *context) {
+  TripInfo *trip = top_trip();
   // Safety check to make sure menu layer exists and is visible
-  if (!s_menu_layer || layer_get_hidden(menu_layer_get_layer(s_menu_layer))) {
+  if (!trip->menu_layer || layer_get_hidden(menu_layer_get_layer(trip->menu_layer))) {
     return;
   }
 
   // Safety check to prevent scrolling past the end
-  MenuIndex index = menu_layer_get_selected_index(s_menu_layer);
-  if (index.row >= s_num_stops - 1) {
+  MenuIndex index = menu_layer_get_selected_index(trip->menu_layer);
+  if (index.row >= trip->num_stops - 1) {
     return;
   }
 
-  menu_layer_set_selected_next(s_menu_layer, false, MenuRowAlignCenter, true);
+  menu_layer_set_selected_next(trip->menu_layer, false, MenuRowAlignCenter, true);
 }
 
 static void menu_select_handler(ClickRecognizerRef recognizer, void *context) {
+  TripInfo *trip = top_trip();
   // Safety check
-  if (!s_menu_layer || layer_get_hidden(menu_layer_get_layer(s_menu_layer))) {
+  if (!trip->menu_layer || layer_get_hidden(menu_layer_get_layer(trip->menu_layer))) {
     return;
   }
 
-  MenuIndex index = menu_layer_get_selected_index(s_menu_layer);
+  MenuIndex index = menu_layer_get_selected_index(trip->menu_layer);
   // Validate index before using it
-  if (index.row < s_num_stops) {
-    menu_select_callback(s_menu_layer, &index, NULL);
+  if (index.row < trip->num_stops) {
+    menu_select_callback(trip->menu_layer, &index, trip);
   }
 }
 
-static AppTimer *s_scroll_timer = NULL;
-static bool s_scrolling_up = false;
-
 static void scroll_timer_callback(void *data) {
+  TripInfo *trip = data;
+  trip->scroll_timer = NULL;
   // Safety check
-  if (!s_menu_layer || layer_get_hidden(menu_layer_get_layer(s_menu_layer))) {
+  if (!trip->menu_layer || layer_get_hidden(menu_layer_get_layer(trip->menu_layer))) {
     return;
   }
   
   // Continue scrolling in the appropriate direction
-  if (s_scrolling_up) {
-    MenuIndex index = menu_layer_get_selected_index(s_menu_layer);
+  if (trip->scrolling_up) {
+    MenuIndex index = menu_layer_get_selected_index(trip->menu_layer);
     if (index.row > 0) {
-      menu_layer_set_selected_next(s_menu_layer, true, MenuRowAlignCenter, true);
+      menu_layer_set_selected_next(trip->menu_layer, true, MenuRowAlignCenter, true);
       // Schedule next scroll
-      s_scroll_timer = app_timer_register(200, scroll_timer_callback, NULL);
+      trip->scroll_timer = app_timer_register(200, scroll_timer_callback, trip);
     }
   } else {
-    MenuIndex index = menu_layer_get_selected_index(s_menu_layer);
-    if (index.row < s_num_stops - 1) {
-      menu_layer_set_selected_next(s_menu_layer, false, MenuRowAlignCenter, true);
+    MenuIndex index = menu_layer_get_selected_index(trip->menu_layer);
+    if (index.row < trip->num_stops - 1) {
+      menu_layer_set_selected_next(trip->menu_layer, false, MenuRowAlignCenter, true);
       // Schedule next scroll
-      s_scroll_timer = app_timer_register(200, scroll_timer_callback, NULL);
+      trip->scroll_timer = app_timer_register(200, scroll_timer_callback, trip);
     }
   }
 }
 
 static void menu_up_long_start(ClickRecognizerRef recognizer, void *context) {
+  TripInfo *trip = top_trip();
   // Safety check
-  if (!s_menu_layer || layer_get_hidden(menu_layer_get_layer(s_menu_layer))) {
+  if (!trip->menu_layer || layer_get_hidden(menu_layer_get_layer(trip->menu_layer))) {
     return;
   }
   
   // First scroll once immediately
-  MenuIndex index = menu_layer_get_selected_index(s_menu_layer);
+  MenuIndex index = menu_layer_get_selected_index(trip->menu_layer);
   if (index.row == 0) {
-    deactivate_menu();
-    show_info();
+    deactivate_menu(trip);
+    show_info(trip);
     return;
   }
   
   // Set scrolling direction and start continuous scrolling
-  s_scrolling_up = true;
-  menu_layer_set_selected_next(s_menu_layer, true, MenuRowAlignCenter, true);
+  trip->scrolling_up = true;
+  menu_layer_set_selected_next(trip->menu_layer, true, MenuRowAlignCenter, true);
   // Start timer for continuous scrolling
-  s_scroll_timer = app_timer_register(200, scroll_timer_callback, NULL);
+  trip->scroll_timer = app_timer_register(200, scroll_timer_callback, trip);
 }
 
 static void menu_down_long_start(ClickRecognizerRef recognizer, void *context) {
+  TripInfo *trip = top_trip();
   // Safety check
-  if (!s_menu_layer || layer_get_hidden(menu_layer_get_layer(s_menu_layer))) {
+  if (!trip->menu_layer || layer_get_hidden(menu_layer_get_layer(trip->menu_layer))) {
     return;
   }
   
   // First scroll once immediately
-  MenuIndex index = menu_layer_get_selected_index(s_menu_layer);
-  if (index.row >= s_num_stops - 1) {
+  MenuIndex index = menu_layer_get_selected_index(trip->menu_layer);
+  if (index.row >= trip->num_stops - 1) {
     return;
   }
   
   // Set scrolling direction and start continuous scrolling
-  s_scrolling_up = false;
-  menu_layer_set_selected_next(s_menu_layer, false, MenuRowAlignCenter, true);
+  trip->scrolling_up = false;
+  menu_layer_set_selected_next(trip->menu_layer, false, MenuRowAlignCenter, true);
   // Start timer for continuous scrolling
-  s_scroll_timer = app_timer_register(200, scroll_timer_callback, NULL);
+  trip->scroll_timer = app_timer_register(200, scroll_timer_callback, trip);
 }
 
 static void menu_long_stop(ClickRecognizerRef recognizer, void *context) {
+  TripInfo *trip = top_trip();
   // Cancel any ongoing scrolling timer
-  if (s_scroll_timer) {
-    app_timer_cancel(s_scroll_timer);
-    s_scroll_timer = NULL;
+  if (trip->scroll_timer) {
+    app_timer_cancel(trip->scroll_timer);
+    trip->scroll_timer = NULL;
   }
 }
 
@@ -449,18 +422,34 @@ static void menu_click_config_provider(void *context) {
   window_long_click_subscribe(BUTTON_ID_DOWN, 200, menu_down_long_start, menu_long_stop);
 }
 
-static void show_info() {
+static void show_info(TripInfo *trip) {
   // First make sure menu is properly deactivated
-  if (!layer_get_hidden(menu_layer_get_layer(s_menu_layer))) {
-    deactivate_menu();
+  if (!layer_get_hidden(menu_layer_get_layer(trip->menu_layer))) {
+    deactivate_menu(trip);
   }
   
   // Then show info layer and set click provider
-  layer_set_hidden(s_info_layer, false);
-  window_set_click_config_provider(s_window, info_click_config_provider);
+  layer_set_hidden(trip->info_layer, false);
+  window_set_click_config_provider(trip->window, info_click_config_provider);
+}
+
+// The destination only changes with MORE_INFO, so it is measured once per width
+static int16_t get_destination_height(TripInfo *trip, GFont font, GRect box) {
+  if (trip->destination_measured_width != box.size.w) {
+    trip->destination_height = graphics_text_layout_get_content_size(
+      trip->destination, font, box, GTextOverflowModeWordWrap, GTextAlignmentCenter
+    ).h;
+    trip->destination_measured_width = box.size.w;
+  }
+  return trip->destination_height;
 }
 
 static void info_layer_update_proc(Layer *layer, GContext *ctx) {
+  TripInfo *trip = window_get_user_data(layer_get_window(layer));
+  if (!trip->first_draw_traced) {
+    trip->first_draw_traced = true;
+    trace_event(TRACE_FIRST_DRAW, TRACE_WINDOW_MORE_INFO);
+  }
   #if PBL_ROUND
   GRect bounds = layer_get_bounds(layer);
 
@@ -474,15 +463,15 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
   
   // Draw the line name at top (centered)
   graphics_context_set_text_color(ctx, GColorBlack);
-  graphics_draw_text(ctx, s_line_name, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
+  graphics_draw_text(ctx, trip->line_name, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
                      GRect(x_offset, y_offset, bounds.size.w - (x_offset * 2), line_height), 
                      GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
   y_offset += line_height + 5;
   
   // Draw the platform (centered)
-  if (s_platform != NULL && strlen(s_platform) > 0) {
-    char platform_text[strlen(s_platform) + 11];
-    snprintf(platform_text, sizeof(platform_text), "Platform: %s", s_platform);
+  if (trip->platform != NULL && strlen(trip->platform) > 0) {
+    char platform_text[strlen(trip->platform) + 11];
+    snprintf(platform_text, sizeof(platform_text), "Platform: %s", trip->platform);
     graphics_draw_text(ctx, platform_text, fonts_get_system_font(FONT_KEY_GOTHIC_14),
                        GRect(x_offset, y_offset, bounds.size.w - (x_offset * 2), line_height), 
                        GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
@@ -493,27 +482,27 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
   int half_width = (bounds.size.w - (x_offset * 2)) / 2;
   
   // Draw the time (left side)
-  graphics_draw_text(ctx, s_time, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
+  graphics_draw_text(ctx, trip->time, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
                      GRect(x_offset - 8, y_offset, half_width, line_height), 
                      GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
   
   // Draw the delay (right side)
   // if the delay starts with a minus sign, it is negative and the train is early
-  if (s_delay[0] == '-' || strlen(s_delay) == 0) {
+  if (trip->delay[0] == '-' || strlen(trip->delay) == 0) {
     graphics_context_set_text_color(ctx, GColorGreen);
     // If the delay is empty, display "+0"
-    if (strlen(s_delay) == 0) {
+    if (strlen(trip->delay) == 0) {
       graphics_draw_text(ctx, "+0", fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
                          GRect(bounds.size.w/2, y_offset, half_width, line_height), 
                          GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
     } else {
-      graphics_draw_text(ctx, s_delay, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
+      graphics_draw_text(ctx, trip->delay, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
                          GRect(bounds.size.w/2, y_offset, half_width, line_height), 
                          GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
     }
   } else {
     graphics_context_set_text_color(ctx, GColorRed);
-    graphics_draw_text(ctx, s_delay, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
+    graphics_draw_text(ctx, trip->delay, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
                      GRect(bounds.size.w/2, y_offset, half_width, line_height), 
                      GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
   }
@@ -523,10 +512,10 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
   
   // Choose the correct image
   GDrawCommandImage *image = NULL;
-  if (strcmp(s_type, "TRAM") == 0) {
-    image = s_tram_icon;
+  if (strcmp(trip->type, "TRAM") == 0) {
+    image = trip->tram_icon;
   } else {
-    image = s_train_icon;
+    image = trip->train_icon;
   }
 
   // Draw the image in the center of screen
@@ -539,19 +528,16 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
   
   // Draw the destination at the bottom (centered)
   // Calculate the height needed for the destination text
-  GSize destination_size = graphics_text_layout_get_content_size(
-    s_destination, 
+  int16_t destination_height = get_destination_height(trip,
     fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
-    GRect(x_offset, 0, bounds.size.w - (x_offset * 2), bounds.size.h), 
-    GTextOverflowModeWordWrap,
-    GTextAlignmentCenter
+    GRect(x_offset, 0, bounds.size.w - (x_offset * 2), bounds.size.h)
   );
   
   // Cap the height to 3 lines maximum
-  int dest_height = destination_size.h > (line_height * 3) ? (line_height * 3) : destination_size.h;
+  int dest_height = destination_height > (line_height * 3) ? (line_height * 3) : destination_height;
   
   // Position destination text at the bottom
-  graphics_draw_text(ctx, s_destination, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
+  graphics_draw_text(ctx, trip->destination, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
                      GRect(x_offset, bounds.size.h - dest_height - 30, bounds.size.w - (x_offset * 2), dest_height), 
                      GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
   #else
@@ -568,10 +554,10 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
 
   // Choose the correct image
   GDrawCommandImage *image = NULL;
-  if (strcmp(s_type, "TRAM") == 0) {
-    image = s_tram_icon;
+  if (strcmp(trip->type, "TRAM") == 0) {
+    image = trip->tram_icon;
   } else {
-    image = s_train_icon;
+    image = trip->train_icon;
   }
 
   // Draw the image, if it exists
@@ -586,12 +572,12 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
   // Draw the line name
   graphics_context_set_text_color(ctx, GColorBlack);
   #if PBL_DISPLAY_HEIGHT == 228
-  graphics_draw_text(ctx, s_line_name, fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD),
+  graphics_draw_text(ctx, trip->line_name, fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD),
                      GRect(x_offset, y_offset, bounds.size.w - 50, line_height), GTextOverflowModeWordWrap,
                      GTextAlignmentLeft, NULL);
   y_offset += line_height + 15;
   #else
-  graphics_draw_text(ctx, s_line_name, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
+  graphics_draw_text(ctx, trip->line_name, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
                      GRect(x_offset, y_offset, bounds.size.w - 50, line_height), GTextOverflowModeWordWrap,
                      GTextAlignmentLeft, NULL);
   y_offset += line_height + 5;
@@ -599,10 +585,10 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
   
 
   // Draw the platform
-  if (s_platform != NULL && strlen(s_platform) > 0) {
+  if (trip->platform != NULL && strlen(trip->platform) > 0) {
     // Check if platform text would be too long and potentially overlap with image
-    char platform_text[strlen(s_platform) + 11];
-    snprintf(platform_text, sizeof(platform_text), "Platform: %s", s_platform);
+    char platform_text[strlen(trip->platform) + 11];
+    snprintf(platform_text, sizeof(platform_text), "Platform: %s", trip->platform);
     #if PBL_DISPLAY_HEIGHT == 228
     GSize platform_size = graphics_text_layout_get_content_size(
       platform_text,
@@ -621,7 +607,7 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
       y_offset += line_height;
 
       // Second line: just the platform number
-      graphics_draw_text(ctx, s_platform, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
+      graphics_draw_text(ctx, trip->platform, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
                         GRect(x_offset, y_offset, bounds.size.w - (x_offset * 2), line_height), 
                         GTextOverflowModeWordWrap, GTextAlignmentLeft, NULL);
       y_offset += line_height;
@@ -650,7 +636,7 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
       y_offset += line_height;
 
       // Second line: just the platform number
-      graphics_draw_text(ctx, s_platform, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
+      graphics_draw_text(ctx, trip->platform, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
                         GRect(x_offset, y_offset, bounds.size.w - (x_offset * 2), line_height), 
                         GTextOverflowModeWordWrap, GTextAlignmentLeft, NULL);
       y_offset += line_height;
@@ -668,12 +654,12 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
 
   // Draw the time
   #if PBL_DISPLAY_HEIGHT == 228
-  graphics_draw_text(ctx, s_time, fonts_get_system_font(FONT_KEY_BITHAM_30_BLACK),
+  graphics_draw_text(ctx, trip->time, fonts_get_system_font(FONT_KEY_BITHAM_30_BLACK),
                      GRect(x_offset, y_offset, bounds.size.w - (x_offset * 2), line_height), GTextOverflowModeWordWrap,
                      GTextAlignmentLeft, NULL);
   y_offset += line_height + 15;
   #else
-  graphics_draw_text(ctx, s_time, fonts_get_system_font(FONT_KEY_LECO_26_BOLD_NUMBERS_AM_PM),
+  graphics_draw_text(ctx, trip->time, fonts_get_system_font(FONT_KEY_LECO_26_BOLD_NUMBERS_AM_PM),
                      GRect(x_offset, y_offset, bounds.size.w - (x_offset * 2), line_height), GTextOverflowModeWordWrap,
                      GTextAlignmentLeft, NULL);
   y_offset += line_height + 10;
@@ -682,7 +668,7 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
   // Draw the delay
   #if PBL_COLOR
   // if the delay starts with a minus sign, it is negative and the train is early
-  if (s_delay[0] == '-') {
+  if (trip->delay[0] == '-') {
     graphics_context_set_text_color(ctx, GColorGreen);
   } else {
     graphics_context_set_text_color(ctx, GColorRed);
@@ -691,18 +677,18 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
   #if PBL_PLATFORM_APLITE
   //For some reason the LECO font wont display the minus on Aplite
   //So we use the bold numbers font instead
-  graphics_draw_text(ctx, s_delay, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD),
+  graphics_draw_text(ctx, trip->delay, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD),
                      GRect(x_offset, y_offset, bounds.size.w - (x_offset * 2), line_height), GTextOverflowModeWordWrap,
                      GTextAlignmentLeft, NULL);
   #else 
   #if PBL_DISPLAY_HEIGHT == 228
   //For some reason the LECO font wont display the minus on Emery either
   //But we have a bigger screen so we use a different font than Aplite
-  graphics_draw_text(ctx, s_delay, fonts_get_system_font(FONT_KEY_BITHAM_30_BLACK),
+  graphics_draw_text(ctx, trip->delay, fonts_get_system_font(FONT_KEY_BITHAM_30_BLACK),
                      GRect(x_offset, y_offset, bounds.size.w - (x_offset * 2), line_height), GTextOverflowModeWordWrap,
                      GTextAlignmentLeft, NULL);
   #else
-  graphics_draw_text(ctx, s_delay, fonts_get_system_font(FONT_KEY_LECO_26_BOLD_NUMBERS_AM_PM),
+  graphics_draw_text(ctx, trip->delay, fonts_get_system_font(FONT_KEY_LECO_26_BOLD_NUMBERS_AM_PM),
                      GRect(x_offset, y_offset, bounds.size.w - (x_offset * 2), line_height), GTextOverflowModeWordWrap,
                      GTextAlignmentLeft, NULL);
   #endif
@@ -714,116 +700,164 @@ static void info_layer_update_proc(Layer *layer, GContext *ctx) {
   // Draw the destination at the bottom center
   // Calculate the height needed for the destination text (allowing for up to 3 lines)
     #if PBL_DISPLAY_HEIGHT == 228
-    GSize destination_size = graphics_text_layout_get_content_size(
-      s_destination, 
+    int16_t destination_height = get_destination_height(trip,
       fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD),
-      GRect(x_offset, 0, bounds.size.w - (x_offset * 2), bounds.size.h), 
-      GTextOverflowModeWordWrap,
-      GTextAlignmentCenter
+      GRect(x_offset, 0, bounds.size.w - (x_offset * 2), bounds.size.h)
     );
     
     // Cap the height to 3 lines maximum
-    int dest_height = destination_size.h > (line_height * 3) ? (line_height * 3) : destination_size.h;
+    int dest_height = destination_height > (line_height * 3) ? (line_height * 3) : destination_height;
     
     // Position destination text with more space from bottom (20px instead of 10px)
-    graphics_draw_text(ctx, s_destination, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD),
+    graphics_draw_text(ctx, trip->destination, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD),
                        GRect(x_offset, bounds.size.h - dest_height - 20, bounds.size.w - (x_offset * 2), dest_height), 
                        GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
   #else
-  GSize destination_size = graphics_text_layout_get_content_size(
-    s_destination, 
+  int16_t destination_height = get_destination_height(trip,
     fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
-    GRect(x_offset, 0, bounds.size.w - (x_offset * 2), bounds.size.h), 
-    GTextOverflowModeWordWrap,
-    GTextAlignmentCenter
+    GRect(x_offset, 0, bounds.size.w - (x_offset * 2), bounds.size.h)
   );
   
   // Cap the height to 3 lines maximum
-  int dest_height = destination_size.h > (line_height * 3) ? (line_height * 3) : destination_size.h;
+  int dest_height = destination_height > (line_height * 3) ? (line_height * 3) : destination_height;
   
   // Position destination text with more space from bottom (20px instead of 10px)
-  graphics_draw_text(ctx, s_destination, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
+  graphics_draw_text(ctx, trip->destination, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
                      GRect(x_offset, bounds.size.h - dest_height - 20, bounds.size.w - (x_offset * 2), dest_height), 
                      GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
     #endif
   #endif
 }
 
+// Cached text layouts are only valid for the area they were measured in
+static void unobstructed_did_change(void *context) {
+  TripInfo *trip = context;
+  trip->stops_measured = false;
+  trip->destination_measured_width = -1;
+  if (trip->info_layer) {
+    layer_mark_dirty(trip->info_layer);
+  }
+  if (trip->menu_layer) {
+    layer_mark_dirty(menu_layer_get_layer(trip->menu_layer));
+  }
+}
+
 static void window_load(Window *window) {
+  TripInfo *trip = window_get_user_data(window);
   Layer *window_layer = window_get_root_layer(window);
   GRect bounds = layer_get_bounds(window_layer);
+  trace_event(TRACE_WINDOW_LOAD, TRACE_WINDOW_MORE_INFO);
+  trip->first_draw_traced = false;
+
+  #if PBL_DISPLAY_HEIGHT == 228
+  s_stop_font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
+  #else
+  s_stop_font = fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD);
+  #endif
+  trip->stops_measured = false;
+  trip->destination_measured_width = -1;
 
   #if PBL_ROUND
-  s_info_layer = layer_create(GRect(0, 0, bounds.size.w, bounds.size.h));
+  trip->info_layer = layer_create(GRect(0, 0, bounds.size.w, bounds.size.h));
   #else
-  s_status_bar = status_bar_layer_create();
-  status_bar_layer_set_colors(s_status_bar, GColorWhite, GColorBlack);
-  layer_add_child(window_layer, status_bar_layer_get_layer(s_status_bar));
+  trip->status_bar = status_bar_layer_create();
+  status_bar_layer_set_colors(trip->status_bar, GColorWhite, GColorBlack);
+  layer_add_child(window_layer, status_bar_layer_get_layer(trip->status_bar));
 
-  s_info_layer = layer_create(GRect(0, STATUS_BAR_LAYER_HEIGHT, bounds.size.w, bounds.size.h - STATUS_BAR_LAYER_HEIGHT));
+  trip->info_layer = layer_create(GRect(0, STATUS_BAR_LAYER_HEIGHT, bounds.size.w, bounds.size.h - STATUS_BAR_LAYER_HEIGHT));
   #endif
 
-  layer_add_child(window_layer, s_info_layer);
+  layer_add_child(window_layer, trip->info_layer);
 
   #if PBL_DISPLAY_HEIGHT == 228
-  s_tram_icon = gdraw_command_image_create_with_resource(RESOURCE_ID_IMAGE_TRAM_EMERY);
-  s_train_icon = gdraw_command_image_create_with_resource(RESOURCE_ID_IMAGE_TRAIN_EMERY);
+  trip->tram_icon = icon_cache_get(RESOURCE_ID_IMAGE_TRAM_EMERY);
+  trip->train_icon = icon_cache_get(RESOURCE_ID_IMAGE_TRAIN_EMERY);
   #else 
-  s_tram_icon = gdraw_command_image_create_with_resource(RESOURCE_ID_IMAGE_TRAM);
-  s_train_icon = gdraw_command_image_create_with_resource(RESOURCE_ID_IMAGE_TRAIN);
+  trip->tram_icon = icon_cache_get(RESOURCE_ID_IMAGE_TRAM);
+  trip->train_icon = icon_cache_get(RESOURCE_ID_IMAGE_TRAIN);
   #endif
 
   // Set the update proc for the info layer
-  layer_set_update_proc(s_info_layer, info_layer_update_proc);
+  layer_set_update_proc(trip->info_layer, info_layer_update_proc);
+
+  // The stops may have been set before the window was pushed
+  if (trip->stops && !trip->menu_layer) {
+    create_menu_layer(trip);
+  }
 
   window_set_click_config_provider(window, info_click_config_provider);
 }
 
+// Only the trip on screen follows the unobstructed area, the others
+// remeasure when they come back
+static void window_appear(Window *window) {
+  TripInfo *trip = window_get_user_data(window);
+  trip->stops_measured = false;
+  trip->destination_measured_width = -1;
+  #if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  unobstructed_area_service_subscribe((UnobstructedAreaHandlers) {
+    .did_change = unobstructed_did_change,
+  }, trip);
+  #endif
+}
+
+static void window_disappear(Window *window) {
+  TripInfo *trip = window_get_user_data(window);
+  if (trip->scroll_timer) {
+    app_timer_cancel(trip->scroll_timer);
+    trip->scroll_timer = NULL;
+  }
+  #if PBL_API_EXISTS(unobstructed_area_service_unsubscribe)
+  unobstructed_area_service_unsubscribe();
+  #endif
+}
+
 static void window_unload(Window *window) {
+  TripInfo *trip = window_get_user_data(window);
+
   // Free allocated memory
-  free_more_info_memory();
-  free(s_line_name);
-  free(s_destination);
-  free(s_platform);
-  free(s_time);
-  free(s_delay);
-  free(s_type);
+  free_more_info_memory(trip);
+  free_info_memory(trip);
 
-  // Destroy the images
-  if (s_tram_icon != NULL) {
-    gdraw_command_image_destroy(s_tram_icon);
+  // Other trips may still draw the same icons
+  icon_cache_release(trip->tram_icon);
+  icon_cache_release(trip->train_icon);
+
+  if (trip->menu_layer) {
+    menu_layer_destroy(trip->menu_layer);
   }
-  if (s_train_icon != NULL) {
-    gdraw_command_image_destroy(s_train_icon);
+  status_bar_layer_destroy(trip->status_bar);
+  layer_destroy(trip->info_layer);
+  nav_stack_remove(window);
+  if (s_trip == trip) {
+    s_trip = NULL;
   }
-
-  menu_layer_destroy(s_menu_layer);
-  status_bar_layer_destroy(s_status_bar);
-  layer_destroy(s_info_layer);
-  window_destroy(s_window);
-  s_window = NULL;
+  window_destroy(window);
+  free(trip);
 }
 
-void more_info_window_reset_if_existing() {
-  if (s_window) {
-    window_stack_remove(s_window, false);
-    window_destroy(s_window);
-    s_window = NULL;
-  }
+static TripInfo *trip_create() {
+  nav_stack_make_room();
+  TripInfo *trip = malloc(sizeof(TripInfo));
+  if (!trip) {
+    return NULL;
+  }
+  memset(trip, 0, sizeof(TripInfo));
+  free_info_memory(trip);
+  trip->destination_measured_width = -1;
+  trip->window = window_create();
+  window_set_user_data(trip->window, trip);
+  window_set_window_handlers(trip->window, (WindowHandlers) {
+    .load = window_load,
+    .appear = window_appear,
+    .disappear = window_disappear,
+    .unload = window_unload,
+  });
+  return trip;
 }
 
 void more_info_window_push() {
-  if (!s_window) {
-    s_window = window_create();
-    window_set_window_handlers(s_window, (WindowHandlers) {
-      .load = window_load,
-      .unload = window_unload,
-    });
-  }
-// Remove the current window and push the new one
-  Window *current_window = window_stack_get_top_window();
-  if (current_window) {
-    window_stack_remove(current_window, false);
-  }
-  window_stack_push(s_window, true);
-}
\ No newline at end of file
+  if (s_trip && !window_stack_contains_window(s_trip->window)) {
+    nav_stack_push(s_trip->window);
+  }
+}
@@ -1,4 +1,6 @@
 #include "no_internet_window.h"
+#include "loading_window.h"
+#include "../modules/icon_cache.h"
 #include <pebble.h>
 
 static Window *s_window;
@@ -6,6 +8,7 @@ static Layer *s_image_layer;
 static TextLayer *s_message_layer;
 static StatusBarLayer *s_status_bar;
 static GDrawCommandImage *s_no_internet_image;
+static const char *s_message = "Keine Verbindung :(";
 
 static void image_layer_update_proc(Layer *layer, GContext *ctx) {
   // Draw the image in the update proc with the provided context
@@ -34,7 +37,7 @@ static void window_load(Window *window) {
   layer_add_child(window_layer, status_bar_layer_get_layer(s_status_bar));
 
   // Load the image
-  s_no_internet_image = gdraw_command_image_create_with_resource(RESOURCE_ID_IMAGE_WATCH_DISCONNECTED);
+  s_no_internet_image = icon_cache_get(RESOURCE_ID_IMAGE_WATCH_DISCONNECTED);
   
   // Create image layer
   s_image_layer = layer_create(GRect(0, STATUS_BAR_LAYER_HEIGHT, bounds.size.w, bounds.size.h - STATUS_BAR_LAYER_HEIGHT - 40));
@@ -43,7 +46,7 @@ static void window_load(Window *window) {
 
   // Create message layer
   s_message_layer = text_layer_create(GRect(0, bounds.size.h - 40, bounds.size.w, 40));
-  text_layer_set_text(s_message_layer, "Keine Verbindung :(");
+  text_layer_set_text(s_message_layer, s_message);
   #if PBL_DISPLAY_HEIGHT == 228
   text_layer_set_font(s_message_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
   #endif
@@ -54,7 +57,8 @@ static void window_load(Window *window) {
 }
 
 static void window_unload(Window *window) {
-  gdraw_command_image_destroy(s_no_internet_image);
+  icon_cache_release(s_no_internet_image);
+  s_no_internet_image = NULL;
   layer_destroy(s_image_layer);
   text_layer_destroy(s_message_layer);
   status_bar_layer_destroy(s_status_bar);
@@ -63,6 +67,14 @@ static void window_unload(Window *window) {
 }
 
 void no_internet_window_push() {
+  no_internet_window_push_message("Keine Verbindung :(");
+}
+
+void no_internet_window_push_message(const char *message) {
+  s_message = message;
+  if (s_window && window_is_loaded(s_window)) {
+    text_layer_set_text(s_message_layer, s_message);
+  }
   if(!s_window) {
     s_window = window_create();
     window_set_window_handlers(s_window, (WindowHandlers) {
@@ -70,8 +82,10 @@ void no_internet_window_push() {
       .unload = window_unload,
     });
   }
-  //window_stack_push(s_window, true);
-  //replace root window
-  window_stack_pop_all(false);
-  window_stack_push(s_window, true);
+  // Goes over the screens the user kept instead of replacing them, Back
+  // returns to the last board or trip that did load
+  loading_window_remove();
+  if (!window_stack_contains_window(s_window)) {
+    window_stack_push(s_window, true);
+  }
 }
\ No newline at end of file
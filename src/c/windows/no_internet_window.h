@@ -2,4 +2,5 @@
 
 #include <pebble.h>
 
-void no_internet_window_push();
\ No newline at end of file
+void no_internet_window_push();
+void no_internet_window_push_message(const char *message);
\ No newline at end of file
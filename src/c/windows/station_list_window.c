@@ -1,79 +1,56 @@
 #include "station_list_window.h"
 #include "loading_window.h"
+#include "station_window.h"
+#include "../modules/launch_cache.h"
+#include "../modules/payload.h"
+#include "../modules/request_queue.h"
+#include "../modules/trace.h"
 #include <pebble.h>
 
 static Window *s_window;
 static MenuLayer *s_menu_layer;
 static StatusBarLayer *s_status_bar;
 static int s_num_stations = 0;
+// Set while we show the cached screen from the last launch
+static char s_stale_text[16];
 static char s_station_names[10][32];
 static char s_station_distances[10][16];
 static int s_station_ids[10];
+static bool s_first_draw_traced;
+
+void station_list_window_set_stale(time_t fetched_at) {
+  launch_cache_format_stale(s_stale_text, sizeof(s_stale_text), fetched_at);
+}
 
 void station_list_window_set_stations(Tuple *stations_tuple) {
-  // Parse the stations array
-  if (stations_tuple) {
-    const char *data = stations_tuple->value->cstring;
-    const char *ptr = data;
-    s_num_stations = 0;
-
-    while (*ptr != '\0' && s_num_stations < 10) {
-      // Skip to the start of the station name
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      ptr++;
-
-      // Extract the station name
-      const char *start = ptr;
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      size_t len = ptr - start;
-      strncpy(s_station_names[s_num_stations], start, len);
-      s_station_names[s_num_stations][len] = '\0';
-      ptr++;
-
-      // Skip to the start of the distance
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      ptr++;
-
-      // Extract the distance
-      start = ptr;
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      len = ptr - start;
-      strncpy(s_station_distances[s_num_stations], start, len);
-      s_station_distances[s_num_stations][len] = '\0';
-      strcat(s_station_distances[s_num_stations], " km");
-      ptr++;
-
-      // Skip to the start of the ID
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      ptr++;
-
-      // Extract the ID
-      start = ptr;
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      len = ptr - start;
-      char id_str[16];
-      strncpy(id_str, start, len);
-      id_str[len] = '\0';
-      s_station_ids[s_num_stations] = atoi(id_str);
-      ptr++;
-
-      // Skip to the next station
-      while (*ptr != '[' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-
-      s_num_stations++;
+  s_stale_text[0] = '\0';
+  s_num_stations = 0;
+  trace_event(TRACE_PARSE_START, TRACE_WINDOW_STATION_LIST);
+
+  // Each row is the station name, the distance in km and the station ID.
+  // Everything is copied into the fixed buffers, so we read the inbox in place
+  PayloadReader reader;
+  if (!payload_reader_init_tuple(&reader, stations_tuple)) {
+    return;
+  }
+  int count = payload_read_uint8(&reader);
+
+  while (s_num_stations < count && s_num_stations < 10) {
+    const char *name = payload_read_string(&reader);
+    const char *distance = payload_read_string(&reader);
+    int32_t id = payload_read_int32(&reader);
+    if (reader.error) {
+      APP_LOG(APP_LOG_LEVEL_ERROR, "Stations payload truncated after %d rows", s_num_stations);
+      break;
     }
-
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "Total stations: %d", s_num_stations);
-  } else {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "stations_tuple is NULL");
+    payload_copy_string(s_station_names[s_num_stations], sizeof(s_station_names[0]), name);
+    snprintf(s_station_distances[s_num_stations], sizeof(s_station_distances[0]), "%s km", distance);
+    s_station_ids[s_num_stations] = id;
+    s_num_stations++;
   }
+
+  trace_event(TRACE_PARSE_END, s_num_stations);
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Total stations: %d", s_num_stations);
 }
 
 static uint16_t menu_get_num_sections_callback(MenuLayer *menu_layer, void *data) {
@@ -84,7 +61,19 @@ static uint16_t menu_get_num_rows_callback(MenuLayer *menu_layer, uint16_t secti
   return s_num_stations;
 }
 
+static int16_t menu_get_header_height_callback(MenuLayer *menu_layer, uint16_t section_index, void *data) {
+  return s_stale_text[0] != '\0' ? MENU_CELL_BASIC_HEADER_HEIGHT : 0;
+}
+
+static void menu_draw_header_callback(GContext *ctx, const Layer *cell_layer, uint16_t section_index, void *data) {
+  menu_cell_basic_header_draw(ctx, cell_layer, s_stale_text);
+}
+
 static void menu_draw_row_callback(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index, void *data) {
+    if (!s_first_draw_traced) {
+      s_first_draw_traced = true;
+      trace_event(TRACE_FIRST_DRAW, TRACE_WINDOW_STATION_LIST);
+    }
     GRect bounds = layer_get_bounds(cell_layer);
     GRect name_bounds = GRect(5, 2, bounds.size.w - 10, bounds.size.h / 2);
     GRect distance_bounds = GRect(5, bounds.size.h / 2, bounds.size.w - 10, bounds.size.h / 2);
@@ -114,11 +103,12 @@ static void menu_draw_row_callback(GContext *ctx, const Layer *cell_layer, MenuI
 static void menu_select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *data) {
   int station_id = s_station_ids[cell_index->row];
   APP_LOG(APP_LOG_LEVEL_DEBUG, "Selected station ID: %d", station_id);
+  //the phone sends the nearest station's board along with the list
+  if (station_window_show_preloaded(station_id)) {
+    return;
+  }
   //send the station ID to the phone
-  DictionaryIterator *iter;
-  app_message_outbox_begin(&iter);
-  dict_write_int(iter, MESSAGE_KEY_GET_STATION, &station_id, sizeof(int), true);
-  app_message_outbox_send();
+  request_queue_send(MESSAGE_KEY_GET_STATION, station_id);
   //push the loading window
   loading_window_push();
 }
@@ -126,6 +116,8 @@ static void menu_select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, v
 static void window_load(Window *window) {
   Layer *window_layer = window_get_root_layer(window);
   GRect bounds = layer_get_bounds(window_layer);
+  trace_event(TRACE_WINDOW_LOAD, TRACE_WINDOW_STATION_LIST);
+  s_first_draw_traced = false;
   #if PBL_RECT
   // Create the status bar
   s_status_bar = status_bar_layer_create();
@@ -141,6 +133,8 @@ static void window_load(Window *window) {
   menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
     .get_num_sections = menu_get_num_sections_callback,
     .get_num_rows = menu_get_num_rows_callback,
+    .get_header_height = menu_get_header_height_callback,
+    .draw_header = menu_draw_header_callback,
     .draw_row = menu_draw_row_callback,
     .select_click = menu_select_callback,
   });
@@ -164,10 +158,17 @@ void station_list_window_push() {
       .unload = window_unload,
     });
   }
-  // Remove the current window and push the new one
-  Window *current_window = window_stack_get_top_window();
-  if (current_window) {
-    window_stack_remove(current_window, false);
+  // Fresh stations for the list we already have, redraw it where it is. The
+  // user may be reading a board they opened from it by now.
+  if (window_stack_contains_window(s_window)) {
+    if (s_menu_layer) {
+      menu_layer_reload_data(s_menu_layer);
+    }
+    return;
   }
+  // The list replaces the spinner or the cached board from the last launch,
+  // never a screen the user opened
+  loading_window_remove();
+  station_window_remove_stale();
   window_stack_push(s_window, true);
 }
\ No newline at end of file
@@ -2,5 +2,9 @@
 
 #include <pebble.h>
 
+// Fields of one row in the payload, see payload_fit_rows()
+#define STATIONS_ROW_FORMAT "ssi"
+
 void station_list_window_set_stations(Tuple *stations_tuple);
+void station_list_window_set_stale(time_t fetched_at);
 void station_list_window_push();
\ No newline at end of file
@@ -1,133 +1,308 @@
 #include "station_window.h"
 #include "loading_window.h"
+#include "../modules/arena.h"
+#include "../modules/icon_cache.h"
+#include "../modules/launch_cache.h"
+#include "../modules/nav_stack.h"
+#include "../modules/payload.h"
+#include "../modules/request_queue.h"
+#include "../modules/trace.h"
 #include <pebble.h>
 
-static Window *s_window;
-static MenuLayer *s_menu_layer;
-static StatusBarLayer *s_status_bar;
-static int s_num_stations = 0;
-
-static char **s_station_lines = NULL;
-static char **s_station_destinations = NULL;
-static char **s_station_times = NULL;
-static char **s_station_platforms = NULL;
-
-void free_station_memory() {
-  if (s_station_lines) {
-    for (int i = 0; i < s_num_stations; i++) {
-      free(s_station_lines[i]);
-      free(s_station_destinations[i]);
-      free(s_station_times[i]);
-      free(s_station_platforms[i]);
+// Longest countdown we show, "in 59 min" or "12:34"
+#define COUNTDOWN_SIZE 12
+// Trains stay on the board for a minute after they are due
+#define DEPARTED_AFTER 60
+// A preloaded board older than this is refreshed as soon as it is shown
+#define PRELOAD_MAX_AGE 30
+// The line type icon in front of each row, only on rect where the text is left aligned
+#if PBL_DISPLAY_HEIGHT == 228
+#define ROW_ICON_SIZE 28
+#else
+#define ROW_ICON_SIZE 20
+#endif
+
+// What the icon in front of a row shows. The rows don't carry the product,
+// the line name gives it away ("STR 4", "Bus 132", "S 12", "RE 5"...)
+typedef enum {
+  LINE_TYPE_TRAIN,
+  LINE_TYPE_TRAM,
+  LINE_TYPE_BUS,
+} LineType;
+
+// One board row, built when the payload arrives. The subtitle is rewritten
+// in place when the countdown changes, the draw callback only ever reads
+// destination and subtitle.
+typedef struct {
+  char *line;
+  char *destination;
+  time_t departs_at;
+  char *platform;
+  // what GET_MORE_INFO asks the phone for
+  char *trip_id;
+  int32_t station_id;
+  char *subtitle;
+  uint16_t subtitle_size;
+  // what the subtitle currently says, see countdown_minutes()
+  int16_t minutes_shown;
+  uint8_t line_type;
+} Departure;
+
+// Everything one board needs. Boards stay alive below whatever is pushed over
+// them until they are popped or dropped by the nav stack, see nav_stack.h
+typedef struct Board {
+  Window *window;
+  MenuLayer *menu_layer;
+  StatusBarLayer *status_bar;
+  int num_stations;
+  // Set while we show the cached screen from the last launch
+  char stale_text[16];
+  // The payload the rows' strings point into and their subtitles share one
+  // arena. Big boards arrive in several chunks: the arena starts out sized
+  // for the first one, every later chunk adds a block of its own and the
+  // row array grows with it. A chunk the heap has no room for only loses
+  // its own rows, whatever arrived before stays on the board.
+  Arena *arena;
+  Departure *departures;
+  int departures_capacity;
+  // The rest of the board comes in chunks with the request id of the first.
+  // They keep coming after the user moved on, the phone counts on us having them.
+  int32_t chunk_request_id;
+  int next_chunk;
+  int expected_rows;
+  time_t loaded_at;
+  // The board refreshes itself while it is on screen, see station_window_set_refresh()
+  int32_t station_id;
+  int refresh_interval;
+  AppTimer *refresh_timer;
+  // Departed trains stay in departures so row indices match the board on the
+  // phone, the menu only shows the rows listed here
+  uint16_t *visible_rows;
+  int num_visible;
+  int visible_capacity;
+  bool first_draw_traced;
+  bool shown;
+  // Whether we have the rows the phone diffs refreshes for this station
+  // against. It keeps one board per station, any other board of the
+  // station has to be sent in full before it can take deltas again.
+  bool synced;
+  // Shared with every other board, see icon_cache.h. There is none for buses.
+  GDrawCommandImage *train_icon;
+  GDrawCommandImage *tram_icon;
+  struct Board *next;
+} Board;
+
+// The board the phone's chunks, deltas and refresh settings go to: the one
+// on screen, or the one that is about to be pushed (or preloaded)
+static Board *s_board = NULL;
+// The board on screen, for the minute tick
+static Board *s_visible = NULL;
+// Every board that is allocated, on the stack or preloaded
+static Board *s_boards = NULL;
+static GFont s_title_font;
+static GFont s_subtitle_font;
+
+static void free_station_memory(Board *board) {
+  arena_destroy(board->arena);
+  board->arena = NULL;
+  free(board->departures);
+  board->departures = NULL;
+  board->departures_capacity = 0;
+  board->num_stations = 0;
+  free(board->visible_rows);
+  board->visible_rows = NULL;
+  board->visible_capacity = 0;
+  board->num_visible = 0;
+}
+
+// The phone just sent rows for the board's station, every other board of it is behind
+static void mark_synced(Board *board) {
+  for (Board *other = s_boards; other; other = other->next) {
+    if (other->station_id == board->station_id) {
+      other->synced = false;
+    }
+  }
+  board->synced = true;
+}
+
+// Whole minutes until the train is due, 0 once it is. Everything an hour
+// or more away shows its clock time, which only changes with the data.
+static int16_t countdown_minutes(const Departure *departure, time_t now) {
+  int minutes = (departure->departs_at - now) / 60;
+  if (minutes < 0) {
+    return 0;
+  }
+  return minutes < 60 ? minutes : 60;
+}
+
+// "in 3 min - S 12 - 3", or "in 3 min - S 12" if there is no platform
+static void format_subtitle(Departure *departure, time_t now) {
+  char countdown[COUNTDOWN_SIZE];
+  departure->minutes_shown = countdown_minutes(departure, now);
+  if (departure->minutes_shown == 0) {
+    strncpy(countdown, "jetzt", sizeof(countdown));
+  } else if (departure->minutes_shown < 60) {
+    snprintf(countdown, sizeof(countdown), "in %d min", departure->minutes_shown);
+  } else {
+    strftime(countdown, sizeof(countdown), "%H:%M", localtime(&departure->departs_at));
+  }
+  if (departure->platform[0] != '\0') {
+    snprintf(departure->subtitle, departure->subtitle_size, "%s - %s - %s", countdown, departure->line, departure->platform);
+  } else {
+    snprintf(departure->subtitle, departure->subtitle_size, "%s - %s", countdown, departure->line);
+  }
+}
+
+static bool build_subtitle(Board *board, Departure *departure) {
+  departure->subtitle_size = strlen(departure->line) + strlen(departure->platform) + COUNTDOWN_SIZE + 7;
+  departure->subtitle = arena_alloc(board->arena, departure->subtitle_size);
+  if (!departure->subtitle) {
+    return false;
+  }
+  format_subtitle(departure, time(NULL));
+  return true;
+}
+
+static uint8_t line_type(const char *line) {
+  if (strncmp(line, "STR", 3) == 0 || strncmp(line, "Tram", 4) == 0) {
+    return LINE_TYPE_TRAM;
+  }
+  if (strncmp(line, "Bus", 3) == 0) {
+    return LINE_TYPE_BUS;
+  }
+  return LINE_TYPE_TRAIN;
+}
+
+static bool has_departed(const Departure *departure, time_t now) {
+  return departure->departs_at + DEPARTED_AFTER < now;
+}
+
+// Lists the rows that are still to come. Returns whether that changed.
+static bool update_visible_rows(Board *board, time_t now) {
+  if (board->visible_capacity < board->num_stations) {
+    uint16_t *visible_rows = realloc(board->visible_rows, board->num_stations * sizeof(uint16_t));
+    if (!visible_rows) {
+      return false;
     }
-    free(s_station_lines);
-    free(s_station_destinations);
-    free(s_station_times);
-    free(s_station_platforms);
-    s_station_lines = NULL;
-    s_station_destinations = NULL;
-    s_station_times = NULL;
-    s_station_platforms = NULL;
-  }
-}
-
-void station_window_set_station(Tuple *station_tuple) {
-  // Free previous allocations
-  free_station_memory();
-
-  // Parse the station information
-  if (station_tuple) {
-    const char *data = station_tuple->value->cstring;
-    const char *ptr = data;
-    s_num_stations = 0;
-
-    // Count the number of stations
-    while (*ptr != '\0') {
-      if (*ptr == '[') {
-        s_num_stations++;
-      }
-      ptr++;
+    board->visible_rows = visible_rows;
+    board->visible_capacity = board->num_stations;
+  }
+  bool changed = false;
+  int num_visible = 0;
+  for (int i = 0; i < board->num_stations; i++) {
+    if (!has_departed(&board->departures[i], now)) {
+      changed |= num_visible >= board->num_visible || board->visible_rows[num_visible] != i;
+      board->visible_rows[num_visible++] = i;
     }
+  }
+  changed |= num_visible != board->num_visible;
+  board->num_visible = num_visible;
+  return changed;
+}
+
+// Makes room for at least capacity rows, with a few to spare once the
+// board grows so inserts from updates don't move it every time
+static bool reserve_departures(Board *board, int capacity) {
+  if (capacity <= board->departures_capacity) {
+    return true;
+  }
+  if (board->departures_capacity > 0 && capacity < board->departures_capacity + 8) {
+    capacity = board->departures_capacity + 8;
+  }
+  Departure *departures = realloc(board->departures, capacity * sizeof(Departure));
+  if (!departures) {
+    return false;
+  }
+  board->departures = departures;
+  board->departures_capacity = capacity;
+  return true;
+}
 
-    // Allocate memory for the stations
-    s_station_lines = malloc(s_num_stations * sizeof(char *));
-    s_station_destinations = malloc(s_num_stations * sizeof(char *));
-    s_station_times = malloc(s_num_stations * sizeof(char *));
-    s_station_platforms = malloc(s_num_stations * sizeof(char *));
-
-    // Parse the stations
-    ptr = data;
-    s_num_stations = 0;
-    while (*ptr != '\0') {
-      // Skip to the start of the Line
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      ptr++;
-
-      // Extract the Line
-      const char *start = ptr;
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      size_t len = ptr - start;
-      s_station_lines[s_num_stations] = malloc(len + 1);
-      strncpy(s_station_lines[s_num_stations], start, len);
-      s_station_lines[s_num_stations][len] = '\0';
-      ptr++;
-
-      // Skip to the start of the Destination Name
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      ptr++;
-
-      // Extract the Destination Name
-      start = ptr;
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      len = ptr - start;
-      s_station_destinations[s_num_stations] = malloc(len + 1);
-      strncpy(s_station_destinations[s_num_stations], start, len);
-      s_station_destinations[s_num_stations][len] = '\0';
-      ptr++;
-
-      // Skip to the start of the Time
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      ptr++;
-
-      // Extract the Time
-      start = ptr;
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      len = ptr - start;
-      s_station_times[s_num_stations] = malloc(len + 1);
-      strncpy(s_station_times[s_num_stations], start, len);
-      s_station_times[s_num_stations][len] = '\0';
-      ptr++;
-
-      // Skip to the start of the Platform Number
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      ptr++;
-
-      // Extract the Platform Number
-      start = ptr;
-      while (*ptr != '"' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-      len = ptr - start;
-      s_station_platforms[s_num_stations] = malloc(len + 1);
-      strncpy(s_station_platforms[s_num_stations], start, len);
-      s_station_platforms[s_num_stations][len] = '\0';
-      ptr++;
-
-      // Skip to the next station
-      while (*ptr != '[' && *ptr != '\0') ptr++;
-      if (*ptr == '\0') break;
-
-      s_num_stations++;
+// Each row is line, destination, departure time (epoch seconds), platform,
+// trip id and the id of the station the departure is from
+static bool read_departure(Board *board, PayloadReader *reader, Departure *departure) {
+  departure->line = payload_read_string(reader);
+  departure->destination = payload_read_string(reader);
+  departure->departs_at = payload_read_int32(reader);
+  departure->platform = payload_read_string(reader);
+  departure->trip_id = payload_read_string(reader);
+  departure->station_id = payload_read_int32(reader);
+  if (reader->error) {
+    return false;
+  }
+  departure->line_type = line_type(departure->line);
+  return build_subtitle(board, departure);
+}
+
+// Copies the rest of the chunk into the arena and appends its rows. Out of
+// heap, the rows that still fit are kept and the rest of the chunk is lost.
+static void append_departures(Board *board, PayloadReader *reader, int count) {
+  uint16_t remaining = payload_reader_remaining(reader);
+  if (!reserve_departures(board, board->num_stations + count)) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "No room for %d more rows, keeping %d", count, board->num_stations);
+    count = board->departures_capacity - board->num_stations;
+  }
+  payload_reader_copy_to(reader, arena_alloc(board->arena, remaining));
+
+  for (int i = 0; i < count; i++) {
+    if (!read_departure(board, reader, &board->departures[board->num_stations])) {
+      APP_LOG(APP_LOG_LEVEL_ERROR, "Station payload truncated after %d rows", board->num_stations);
+      break;
     }
+    board->num_stations++;
+  }
+  update_visible_rows(board, time(NULL));
+}
 
-  } else {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "station_tuple is NULL");
+// New rows for a board the user is looking at keep the selection where it is
+static void reload_menu(Board *board) {
+  if (board->menu_layer && window_is_loaded(board->window)) {
+    menu_layer_reload_data(board->menu_layer);
+  }
+}
+
+static void refresh_timer_callback(void *context) {
+  Board *board = context;
+  board->refresh_timer = NULL;
+  // A delta against rows we don't have would break the board
+  request_queue_send_background(board->synced ? MESSAGE_KEY_REFRESH_STATION : MESSAGE_KEY_RELOAD_STATION, board->station_id);
+  board->refresh_timer = app_timer_register(board->refresh_interval * 1000, refresh_timer_callback, board);
+}
+
+static void start_refresh(Board *board) {
+  if (!board->refresh_timer && board->refresh_interval > 0 && board->station_id != 0) {
+    board->refresh_timer = app_timer_register(board->refresh_interval * 1000, refresh_timer_callback, board);
+  }
+}
+
+static void stop_refresh(Board *board) {
+  if (board->refresh_timer) {
+    app_timer_cancel(board->refresh_timer);
+    board->refresh_timer = NULL;
+  }
+}
+
+// The countdowns change once a minute, the data itself only with a refresh.
+// Only rows whose text changed are rewritten and the menu is only redrawn
+// if there was one, trains that left are taken off the board.
+static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
+  Board *board = s_visible;
+  if (!board) {
+    return;
+  }
+  time_t now = time(NULL);
+  bool text_changed = false;
+  for (int i = 0; i < board->num_stations; i++) {
+    Departure *departure = &board->departures[i];
+    if (countdown_minutes(departure, now) != departure->minutes_shown) {
+      format_subtitle(departure, now);
+      text_changed = true;
+    }
+  }
+  if (update_visible_rows(board, now)) {
+    menu_layer_reload_data(board->menu_layer);
+  } else if (text_changed) {
+    layer_mark_dirty(menu_layer_get_layer(board->menu_layer));
   }
 }
 
@@ -136,13 +311,40 @@ static uint16_t menu_get_num_sections_callback(MenuLayer *menu_layer, void *data
 }
 
 static uint16_t menu_get_num_rows_callback(MenuLayer *menu_layer, uint16_t section_index, void *data) {
-  return s_num_stations;
+  Board *board = data;
+  return board->num_visible;
+}
+
+// The cached board from the last launch says how old it is, the favorites
+// board says what it is
+static const char *header_text(Board *board) {
+  if (board->stale_text[0] != '\0') {
+    return board->stale_text;
+  }
+  return board->station_id == STATION_ID_FAVORITES ? "Favoriten" : NULL;
+}
+
+static int16_t menu_get_header_height_callback(MenuLayer *menu_layer, uint16_t section_index, void *data) {
+  return header_text(data) ? MENU_CELL_BASIC_HEADER_HEIGHT : 0;
+}
+
+static void menu_draw_header_callback(GContext *ctx, const Layer *cell_layer, uint16_t section_index, void *data) {
+  const char *text = header_text(data);
+  if (text) {
+    menu_cell_basic_header_draw(ctx, cell_layer, text);
+  }
 }
 
 static void menu_draw_row_callback(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index, void *data) {
+  Board *board = data;
   GRect bounds = layer_get_bounds(cell_layer);
-  GRect title_bounds = GRect(5, 2, bounds.size.w - 10, bounds.size.h / 2);
-  GRect subtitle_bounds = GRect(5, bounds.size.h / 2, bounds.size.w - 10, bounds.size.h / 2);
+  #if PBL_RECT
+  int16_t text_x = ROW_ICON_SIZE + 8;
+  #else
+  int16_t text_x = 5;
+  #endif
+  GRect title_bounds = GRect(text_x, 2, bounds.size.w - text_x - 5, bounds.size.h / 2);
+  GRect subtitle_bounds = GRect(text_x, bounds.size.h / 2, bounds.size.w - text_x - 5, bounds.size.h / 2);
 
   bool is_selected = menu_cell_layer_is_highlighted(cell_layer);
 
@@ -150,102 +352,440 @@ static void menu_draw_row_callback(GContext *ctx, const Layer *cell_layer, MenuI
   graphics_context_set_fill_color(ctx, is_selected ? PBL_IF_BW_ELSE(GColorBlack, GColorDarkGreen) : GColorWhite);
   graphics_fill_rect(ctx, bounds, 0, GCornerNone);
 
-  // Create the title string
-  static char title[64];
-  snprintf(title, sizeof(title), "%s", s_station_destinations[cell_index->row]);
+  if (!board->first_draw_traced) {
+    board->first_draw_traced = true;
+    trace_event(TRACE_FIRST_DRAW, TRACE_WINDOW_STATION);
+  }
+  Departure *departure = &board->departures[board->visible_rows[cell_index->row]];
 
-  // Create the subtitle string
-  static char subtitle[64];
-  if (strlen(s_station_platforms[cell_index->row]) > 0) {
-    snprintf(subtitle, sizeof(subtitle), "%s - %s - %s", s_station_times[cell_index->row], s_station_lines[cell_index->row], s_station_platforms[cell_index->row]);
-  } else {
-    snprintf(subtitle, sizeof(subtitle), "%s - %s", s_station_times[cell_index->row], s_station_lines[cell_index->row]);
+  #if PBL_RECT
+  GDrawCommandImage *icon = NULL;
+  if (departure->line_type == LINE_TYPE_TRAM) {
+    icon = board->tram_icon;
+  } else if (departure->line_type == LINE_TYPE_TRAIN) {
+    icon = board->train_icon;
   }
-  #if PBL_DISPLAY_HEIGHT == 228
-  graphics_draw_text(ctx, title, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD), 
-                      title_bounds, GTextOverflowModeTrailingEllipsis, 
-                      PBL_IF_RECT_ELSE(GTextAlignmentLeft, GTextAlignmentCenter), NULL);
-  graphics_draw_text(ctx, subtitle, fonts_get_system_font(FONT_KEY_GOTHIC_18), 
-                      subtitle_bounds, GTextOverflowModeTrailingEllipsis, 
-                      PBL_IF_RECT_ELSE(GTextAlignmentLeft, GTextAlignmentCenter), NULL);
-  #else
-  graphics_draw_text(ctx, title, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD), 
+  if (icon) {
+    GPoint icon_origin = GPoint(4, (bounds.size.h - ROW_ICON_SIZE) / 2);
+    // The icons are drawn in black, keep them visible on the highlight
+    if (is_selected) {
+      graphics_context_set_fill_color(ctx, GColorWhite);
+      graphics_fill_rect(ctx, GRect(icon_origin.x - 1, icon_origin.y - 1, ROW_ICON_SIZE + 2, ROW_ICON_SIZE + 2), 3, GCornersAll);
+    }
+    gdraw_command_image_draw(ctx, icon, icon_origin);
+  }
+  #endif
+  graphics_draw_text(ctx, departure->destination, s_title_font,
                       title_bounds, GTextOverflowModeTrailingEllipsis, 
                       PBL_IF_RECT_ELSE(GTextAlignmentLeft, GTextAlignmentCenter), NULL);
-  graphics_draw_text(ctx, subtitle, fonts_get_system_font(FONT_KEY_GOTHIC_14), 
+  graphics_draw_text(ctx, departure->subtitle, s_subtitle_font,
                       subtitle_bounds, GTextOverflowModeTrailingEllipsis, 
                       PBL_IF_RECT_ELSE(GTextAlignmentLeft, GTextAlignmentCenter), NULL);
-  #endif
 }
 
 static void menu_select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *data) {
-  int index = cell_index->row + 1;
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "Selected station Index: %d", cell_index->row);
-  DictionaryIterator *iter;
-  app_message_outbox_begin(&iter);
-  dict_write_int(iter, MESSAGE_KEY_GET_MORE_INFO, &index, sizeof(int), true);
-  app_message_outbox_send();
+  Board *board = data;
+  Departure *departure = &board->departures[board->visible_rows[cell_index->row]];
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Selected trip %s", departure->trip_id);
+  // The phone needs nothing else to find the trip, even if it has fetched
+  // another board since. If the trip has left it answers with the board it
+  // was picked on, for the favorites that is the merged one.
+  uint32_t key = board->station_id == STATION_ID_FAVORITES ? MESSAGE_KEY_GET_MORE_INFO_FAVORITES : MESSAGE_KEY_GET_MORE_INFO;
+  if (!request_queue_send_text(key, departure->station_id, MESSAGE_KEY_TRIP_ID, departure->trip_id)) {
+    return;
+  }
   //push the loading window
   loading_window_push();
 }
 
+// Long press sends the trace of the last requests to the phone log
+static void menu_select_long_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *data) {
+  trace_send();
+}
+
 static void window_load(Window *window) {
+  Board *board = window_get_user_data(window);
   Layer *window_layer = window_get_root_layer(window);
   GRect bounds = layer_get_bounds(window_layer);
+  trace_event(TRACE_WINDOW_LOAD, TRACE_WINDOW_STATION);
+  board->first_draw_traced = false;
+
+  #if PBL_DISPLAY_HEIGHT == 228
+  s_title_font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
+  s_subtitle_font = fonts_get_system_font(FONT_KEY_GOTHIC_18);
+  #else
+  s_title_font = fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD);
+  s_subtitle_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+  #endif
+
+  #if PBL_RECT
+  // Scaled once for every board, drawing a row never touches the resources
+  board->train_icon = icon_cache_get_scaled(RESOURCE_ID_IMAGE_TRAIN, ROW_ICON_SIZE);
+  board->tram_icon = icon_cache_get_scaled(RESOURCE_ID_IMAGE_TRAM, ROW_ICON_SIZE);
+  #endif
 
   #if PBL_RECT
   // Create the status bar
-  s_status_bar = status_bar_layer_create();
-  status_bar_layer_set_colors(s_status_bar, GColorWhite, GColorBlack);
-  layer_add_child(window_layer, status_bar_layer_get_layer(s_status_bar));
+  board->status_bar = status_bar_layer_create();
+  status_bar_layer_set_colors(board->status_bar, GColorWhite, GColorBlack);
+  layer_add_child(window_layer, status_bar_layer_get_layer(board->status_bar));
 
   // Adjust bounds for the menu layer to account for the status bar
   GRect menu_bounds = GRect(bounds.origin.x, bounds.origin.y + STATUS_BAR_LAYER_HEIGHT, bounds.size.w, bounds.size.h - STATUS_BAR_LAYER_HEIGHT);
   #else
   GRect menu_bounds = GRect(bounds.origin.x, bounds.origin.y, bounds.size.w, bounds.size.h);
   #endif
-  s_menu_layer = menu_layer_create(menu_bounds);
-  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+  board->menu_layer = menu_layer_create(menu_bounds);
+  menu_layer_set_callbacks(board->menu_layer, board, (MenuLayerCallbacks) {
     .get_num_sections = menu_get_num_sections_callback,
     .get_num_rows = menu_get_num_rows_callback,
+    .get_header_height = menu_get_header_height_callback,
+    .draw_header = menu_draw_header_callback,
     .draw_row = menu_draw_row_callback,
     .select_click = menu_select_callback,
+    .select_long_click = menu_select_long_callback,
   });
-  menu_layer_set_highlight_colors(s_menu_layer, PBL_IF_BW_ELSE(GColorBlack, GColorDarkGreen), GColorWhite);
-  menu_layer_set_click_config_onto_window(s_menu_layer, window);
-  layer_add_child(window_layer, menu_layer_get_layer(s_menu_layer));
+  menu_layer_set_highlight_colors(board->menu_layer, PBL_IF_BW_ELSE(GColorBlack, GColorDarkGreen), GColorWhite);
+  menu_layer_set_click_config_onto_window(board->menu_layer, window);
+  layer_add_child(window_layer, menu_layer_get_layer(board->menu_layer));
+}
+
+// Only refresh while the board is actually visible
+static void window_appear(Window *window) {
+  Board *board = window_get_user_data(window);
+  s_board = board;
+  s_visible = board;
+  tick_handler(NULL, MINUTE_UNIT);
+  tick_timer_service_subscribe(MINUTE_UNIT, tick_handler);
+  // Back from something pushed over it. The phone has sent another board of
+  // this station since, so ours can't be patched with a delta any more.
+  if (board->shown && !board->synced && board->station_id != 0) {
+    request_queue_send_background(MESSAGE_KEY_RELOAD_STATION, board->station_id);
+  }
+  board->shown = true;
+  start_refresh(board);
+}
+
+static void window_disappear(Window *window) {
+  Board *board = window_get_user_data(window);
+  // The board pushed over it may have subscribed already
+  if (s_visible == board) {
+    s_visible = NULL;
+    tick_timer_service_unsubscribe();
+  }
+  stop_refresh(board);
+}
+
+static void board_destroy(Board *board) {
+  stop_refresh(board);
+  free_station_memory(board);
+  if (s_board == board) {
+    s_board = NULL;
+  }
+  for (Board **link = &s_boards; *link; link = &(*link)->next) {
+    if (*link == board) {
+      *link = board->next;
+      break;
+    }
+  }
+  window_destroy(board->window);
+  free(board);
 }
 
 static void window_unload(Window *window) {
-  // Free allocated memory
-  free_station_memory();
+  Board *board = window_get_user_data(window);
+  icon_cache_release(board->train_icon);
+  icon_cache_release(board->tram_icon);
+  menu_layer_destroy(board->menu_layer);
+  status_bar_layer_destroy(board->status_bar);
+  nav_stack_remove(window);
+  board_destroy(board);
+}
+
+// A board that was never pushed (a preload nobody picked) has no unload to free it
+static void drop_unshown_board() {
+  if (s_board && !window_stack_contains_window(s_board->window)) {
+    board_destroy(s_board);
+  }
+}
+
+static Board *board_create() {
+  drop_unshown_board();
+  nav_stack_make_room();
+  Board *board = malloc(sizeof(Board));
+  if (!board) {
+    return NULL;
+  }
+  memset(board, 0, sizeof(Board));
+  board->next = s_boards;
+  s_boards = board;
+  board->window = window_create();
+  window_set_user_data(board->window, board);
+  window_set_window_handlers(board->window, (WindowHandlers) {
+    .load = window_load,
+    .appear = window_appear,
+    .disappear = window_disappear,
+    .unload = window_unload,
+  });
+  return board;
+}
+
+// The board on screen gets fresh rows in place if they are for its station,
+// or if it is the cached one from the last launch. Anything else is a new
+// board pushed over it.
+static bool updates_in_place(Board *board, int32_t station_id) {
+  // The spinner of a trip that has left is still over the board it was picked on
+  if (!board || loading_window_get_covered() != board->window) {
+    return false;
+  }
+  return board->stale_text[0] != '\0' || (station_id != 0 && board->station_id == station_id);
+}
+
+void station_window_set_stale(time_t fetched_at) {
+  if (s_board) {
+    launch_cache_format_stale(s_board->stale_text, sizeof(s_board->stale_text), fetched_at);
+  }
+}
+
+void station_window_remove_stale() {
+  if (s_board && s_board->stale_text[0] != '\0' && window_stack_contains_window(s_board->window)) {
+    window_stack_remove(s_board->window, false);
+  }
+}
+
+// Replaces the rows of board with the first chunk of a board for station_id
+static void load_board(Board *board, Tuple *station_tuple, int total_rows, int32_t station_id, int32_t request_id) {
+  board->stale_text[0] = '\0';
+  board->station_id = station_id;
+  mark_synced(board);
+  board->num_stations = 0;
+  board->num_visible = 0;
+  board->chunk_request_id = request_id;
+  board->next_chunk = 1;
+  board->expected_rows = total_rows;
+  board->loaded_at = time(NULL);
+  trace_event(TRACE_PARSE_START, TRACE_WINDOW_STATION);
+
+  PayloadReader reader;
+  if (!payload_reader_init_tuple(&reader, station_tuple)) {
+    return;
+  }
+  int count = payload_read_uint8(&reader);
+
+  // Room for this chunk, every string is used in place in its copy. The
+  // subtitles are at most the row's strings again plus two " - ". The
+  // whole of a big hub in one block is more than aplite's heap has.
+  board->arena = arena_reuse_or_create(board->arena, payload_reader_remaining(&reader) * 2 + sizeof(int));
+  append_departures(board, &reader, count);
+  trace_event(TRACE_PARSE_END, board->num_stations);
+  arena_log_heap("Station");
+  reload_menu(board);
+}
+
+void station_window_set_station(Tuple *station_tuple, int total_rows, int32_t station_id, int32_t request_id) {
+  Board *board = s_board;
+  if (!updates_in_place(board, station_id)) {
+    board = board_create();
+    if (!board) {
+      return;
+    }
+  }
+  s_board = board;
+  load_board(board, station_tuple, total_rows, station_id, request_id);
+}
+
+void station_window_update_station(Tuple *station_tuple, int total_rows, int32_t station_id, int32_t request_id) {
+  // The board on screen asked for it, otherwise the newest one of the station
+  Board *board = s_visible;
+  if (!board || board->station_id != station_id) {
+    board = s_boards;
+    while (board && board->station_id != station_id) {
+      board = board->next;
+    }
+  }
+  // Its board is gone, the phone has to send the next refresh in full
+  if (!board || station_id == 0) {
+    station_window_forget_station(station_id);
+    return;
+  }
+  load_board(board, station_tuple, total_rows, station_id, request_id);
+}
 
-  menu_layer_destroy(s_menu_layer);
-  status_bar_layer_destroy(s_status_bar);
-  window_destroy(s_window);
-  s_window = NULL;
+// The board still waiting for this chunk, wherever it is on the stack
+static Board *find_chunk_board(int chunk_index, int32_t request_id) {
+  for (Board *board = s_boards; board; board = board->next) {
+    if (board->arena && board->chunk_request_id == request_id && board->next_chunk == chunk_index &&
+        board->num_stations < board->expected_rows) {
+      return board;
+    }
+  }
+  return NULL;
 }
 
-void station_window_reset_if_existing() {
-  if (s_window) {
-    window_stack_remove(s_window, false);
-    window_destroy(s_window);
-    s_window = NULL;
+void station_window_append_station(Tuple *station_tuple, int chunk_index, int32_t request_id) {
+  Board *board = find_chunk_board(chunk_index, request_id);
+  // The first chunk was dropped, or it was the rest of a preload we didn't keep
+  if (!board) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Ignoring chunk %d of request %d", chunk_index, (int)request_id);
+    return;
   }
+  board->next_chunk++;
+
+  PayloadReader reader;
+  if (!payload_reader_init_tuple(&reader, station_tuple)) {
+    return;
+  }
+  int count = payload_read_uint8(&reader);
+  append_departures(board, &reader, count);
+  arena_log_heap("Station chunk");
+  reload_menu(board);
 }
 
+// Updates leave the strings of the rows they replaced behind in the arena.
+// Once that is more than the live board, copy the board into a fresh arena.
+static void compact_departures(Board *board) {
+  // Every string with its terminator and alignment, the new arena is a
+  // single block that holds all of them
+  size_t live = sizeof(int);
+  for (int i = 0; i < board->num_stations; i++) {
+    Departure *departure = &board->departures[i];
+    live += strlen(departure->line) + strlen(departure->destination) +
+            strlen(departure->platform) + strlen(departure->trip_id) + departure->subtitle_size + 20;
+  }
+  if (arena_used(board->arena) <= live * 2) {
+    return;
+  }
+  Arena *arena = arena_create(live);
+  if (!arena) {
+    return;
+  }
+  for (int i = 0; i < board->num_stations; i++) {
+    Departure *departure = &board->departures[i];
+    departure->line = arena_strdup(arena, departure->line);
+    departure->destination = arena_strdup(arena, departure->destination);
+    departure->platform = arena_strdup(arena, departure->platform);
+    departure->trip_id = arena_strdup(arena, departure->trip_id);
+    char *subtitle = arena_alloc(arena, departure->subtitle_size);
+    memcpy(subtitle, departure->subtitle, departure->subtitle_size);
+    departure->subtitle = subtitle;
+  }
+  arena_destroy(board->arena);
+  board->arena = arena;
+  arena_log_heap("Station compacted");
+}
+
+// Every row of a STATION_DELTA is [op][index] followed by the fields of a
+// departure. The phone orders them so applying them one after the other
+// turns the board we have into the new one.
+void station_window_apply_delta(Tuple *delta_tuple, int32_t station_id) {
+  Board *board = s_boards;
+  while (board && !(board->synced && board->station_id == station_id)) {
+    board = board->next;
+  }
+  PayloadReader reader;
+  // Without the rows it was diffed against, the board is reloaded on its next refresh
+  if (!board || !board->arena || !payload_reader_init_tuple(&reader, delta_tuple)) {
+    return;
+  }
+  int count = payload_read_uint8(&reader);
+  uint16_t remaining = payload_reader_remaining(&reader);
+  payload_reader_copy_to(&reader, arena_alloc(board->arena, remaining));
+
+  int old_num_visible = board->num_visible;
+  for (int i = 0; i < count; i++) {
+    int op = payload_read_int32(&reader);
+    int index = payload_read_int32(&reader);
+    Departure departure;
+    if (!read_departure(board, &reader, &departure) || index < 0) {
+      APP_LOG(APP_LOG_LEVEL_ERROR, "Station delta truncated after %d rows", i);
+      break;
+    }
+    int num_stations = board->num_stations;
+    Departure *departures = board->departures;
+    if (op == STATION_DELTA_REMOVE && index < num_stations) {
+      memmove(&departures[index], &departures[index + 1], (num_stations - index - 1) * sizeof(Departure));
+      board->num_stations--;
+    } else if (op == STATION_DELTA_INSERT && index <= num_stations && reserve_departures(board, num_stations + 1)) {
+      departures = board->departures;
+      memmove(&departures[index + 1], &departures[index], (num_stations - index) * sizeof(Departure));
+      departures[index] = departure;
+      board->num_stations++;
+    } else if (op == STATION_DELTA_UPDATE && index < num_stations) {
+      departures[index] = departure;
+    }
+  }
+  compact_departures(board);
+  update_visible_rows(board, time(NULL));
+
+  if (board->menu_layer && window_is_loaded(board->window)) {
+    // Same rows, only their text changed: redrawing the visible cells is enough
+    if (board->num_visible != old_num_visible) {
+      menu_layer_reload_data(board->menu_layer);
+    } else {
+      layer_mark_dirty(menu_layer_get_layer(board->menu_layer));
+    }
+  }
+}
+
+// interval is in seconds, 0 turns auto refresh off
+void station_window_set_refresh(int interval) {
+  Board *board = s_board;
+  if (!board) {
+    return;
+  }
+  stop_refresh(board);
+  board->refresh_interval = interval;
+  if (window_stack_get_top_window() == board->window) {
+    start_refresh(board);
+  }
+}
+
+// Keeps a board nobody asked for yet, so picking its station in the list
+// shows it without waiting for the phone. A board on screen always wins.
+void station_window_preload(Tuple *station_tuple, int total_rows, int32_t station_id, int interval) {
+  if (s_board && window_stack_contains_window(s_board->window)) {
+    station_window_forget_station(station_id);
+    return;
+  }
+  station_window_set_station(station_tuple, total_rows, station_id, 0);
+  station_window_set_refresh(interval);
+}
+
+void station_window_forget_station(int32_t station_id) {
+  for (Board *board = s_boards; board; board = board->next) {
+    if (board->station_id == station_id) {
+      board->synced = false;
+    }
+  }
+}
+
+// Pushes the preloaded board on top of the station list if it is the one
+// for station_id. Returns false if the board has to be requested.
+bool station_window_show_preloaded(int32_t station_id) {
+  Board *board = s_board;
+  if (!board || window_stack_contains_window(board->window) || !board->arena ||
+      board->station_id == 0 || board->station_id != station_id) {
+    return false;
+  }
+  nav_stack_push(board->window);
+  if (!board->synced) {
+    request_queue_send_background(MESSAGE_KEY_RELOAD_STATION, station_id);
+  } else if (time(NULL) - board->loaded_at > PRELOAD_MAX_AGE) {
+    request_queue_send_background(MESSAGE_KEY_REFRESH_STATION, station_id);
+  }
+  return true;
+}
+
+// Pushes the board set last, unless it was updated in place on screen
 void station_window_push() {
-  if (!s_window) {
-    s_window = window_create();
-    window_set_window_handlers(s_window, (WindowHandlers) {
-      .load = window_load,
-      .unload = window_unload,
-    });
-  }
-  // Remove the current window and push the new one
-  Window *current_window = window_stack_get_top_window();
-  if (current_window) {
-    window_stack_remove(current_window, false);
-  }
-  window_stack_push(s_window, true);
-}
\ No newline at end of file
+  if (!s_board) {
+    return;
+  }
+  if (!window_stack_contains_window(s_board->window)) {
+    nav_stack_push(s_board->window);
+  } else if (s_board->chunk_request_id != 0 && request_queue_is_current(s_board->chunk_request_id)) {
+    // The spinner over it is this board's, unless the user asked for
+    // something else from it while the phone's own board came in
+    loading_window_remove();
+  }
+}
@@ -2,6 +2,28 @@
 
 #include <pebble.h>
 
-void station_window_set_station(Tuple *station_tuple);
-void station_window_reset_if_existing();
+// Fields of one row in the payload, see payload_fit_rows()
+#define STATION_ROW_FORMAT "ssissi"
+
+// The board the phone merges from the favorite stations, it has no station of its own
+#define STATION_ID_FAVORITES -1
+
+// What a STATION_DELTA row does to the board
+#define STATION_DELTA_UPDATE 0
+#define STATION_DELTA_INSERT 1
+#define STATION_DELTA_REMOVE 2
+
+void station_window_set_station(Tuple *station_tuple, int total_rows, int32_t station_id, int32_t request_id);
+// A refresh sent in full: it only replaces the rows of the station's board, wherever it is
+void station_window_update_station(Tuple *station_tuple, int total_rows, int32_t station_id, int32_t request_id);
+void station_window_append_station(Tuple *station_tuple, int chunk_index, int32_t request_id);
+void station_window_apply_delta(Tuple *delta_tuple, int32_t station_id);
+// The phone sent rows for the station that we dropped, its boards need a reload
+void station_window_forget_station(int32_t station_id);
+void station_window_set_refresh(int interval);
+void station_window_preload(Tuple *station_tuple, int total_rows, int32_t station_id, int interval);
+bool station_window_show_preloaded(int32_t station_id);
+void station_window_set_stale(time_t fetched_at);
+// Drops the cached board from the last launch once something fresh replaces it
+void station_window_remove_stale();
 void station_window_push();
\ No newline at end of file
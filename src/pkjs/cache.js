@@ -0,0 +1,217 @@
+// LRU cache for API responses, keyed by URL.
+// Every entry is fresh for the TTL the caller asks for, after that it is
+// revalidated with If-None-Match so an unchanged response costs no body.
+// Entries are persisted to localStorage and survive the app being closed.
+// At most MAX_CONCURRENT requests run at once, the rest wait their turn.
+
+// [[url, etag, fetchedAt], ...] oldest first. Each body is stored on its own
+// under BODY_KEY_PREFIX + url, so a response only rewrites its own body.
+var INDEX_KEY = "RESPONSE_CACHE_INDEX";
+var BODY_KEY_PREFIX = "RESPONSE_CACHE:";
+var MAX_ENTRIES = 20;
+var MAX_CONCURRENT = 3;
+// A request that stalls longer than this gives its slot back, its waiters
+// get the same answer as without a connection
+var REQUEST_TIMEOUT = 10 * 1000;
+
+// url -> { body, etag, fetchedAt, data }, oldest first (Object key order)
+var entries = load();
+// url -> { req, waiters, start } for requests that have not answered yet,
+// req is null while the request waits for a free slot
+var inFlight = {};
+// urls of the requests waiting for a slot, in the order they get one
+var waiting = [];
+var running = 0;
+
+function load() {
+  var loaded = {};
+  try {
+    var index = JSON.parse(localStorage.getItem(INDEX_KEY)) || [];
+    index.forEach(function(item) {
+      var body = localStorage.getItem(BODY_KEY_PREFIX + item[0]);
+      if (body !== null) {
+        loaded[item[0]] = { body: body, etag: item[1], fetchedAt: item[2] };
+      }
+    });
+  } catch (e) {
+    console.log('Could not load response cache: ' + e);
+  }
+  return loaded;
+}
+
+// Writes the index and, if it changed, the body of one entry
+function save(url, bodyChanged) {
+  var index = Object.keys(entries).map(function(key) {
+    return [key, entries[key].etag, entries[key].fetchedAt];
+  });
+  try {
+    if (bodyChanged) {
+      localStorage.setItem(BODY_KEY_PREFIX + url, entries[url].body);
+    }
+    localStorage.setItem(INDEX_KEY, JSON.stringify(index));
+  } catch (e) {
+    console.log('Could not persist response cache: ' + e);
+  }
+}
+
+function remove(url) {
+  delete entries[url];
+  localStorage.removeItem(BODY_KEY_PREFIX + url);
+}
+
+// Moves the entry to the back so the least recently used one is evicted first
+function touch(url, entry) {
+  delete entries[url];
+  entries[url] = entry;
+  var urls = Object.keys(entries);
+  while (urls.length > MAX_ENTRIES) {
+    remove(urls.shift());
+  }
+}
+
+function parsed(entry) {
+  if (entry.data === undefined) {
+    entry.data = JSON.parse(entry.body);
+  }
+  return entry.data;
+}
+
+function startNext() {
+  while (running < MAX_CONCURRENT && waiting.length > 0) {
+    var pending = inFlight[waiting.shift()];
+    if (pending) {
+      running++;
+      pending.start();
+    }
+  }
+}
+
+// callback(status, data): status is 0 on success, the HTTP status (or -1 for
+// a network error) otherwise. Urgent requests (the user is waiting for them)
+// go ahead of everything that waits for a slot.
+// Returns the handle for abort(), or null if the cache answered right away.
+function getJSON(url, ttl, callback, urgent) {
+  var entry = entries[url];
+  if (entry && Date.now() - entry.fetchedAt < ttl) {
+    touch(url, entry);
+    callback(0, parsed(entry));
+    return null;
+  }
+
+  var waiter = { url: url, callback: callback };
+  // Somebody (e.g. a prefetch) already asked for this, wait for that answer
+  if (inFlight[url]) {
+    inFlight[url].waiters.push(waiter);
+    if (urgent && !inFlight[url].req) {
+      waiting.splice(waiting.indexOf(url), 1);
+      waiting.unshift(url);
+    }
+    return waiter;
+  }
+
+  var pending = { req: null, waiters: [waiter], start: start };
+  inFlight[url] = pending;
+  if (urgent) {
+    waiting.unshift(url);
+  } else {
+    waiting.push(url);
+  }
+  startNext();
+  return waiter;
+
+  function finish(status, data) {
+    if (inFlight[url] !== pending) {
+      return;
+    }
+    delete inFlight[url];
+    running--;
+    startNext();
+    pending.waiters.forEach(function(other) {
+      other.callback(status, data);
+    });
+  }
+
+  function start() {
+    var req = new XMLHttpRequest();
+    pending.req = req;
+    req.open('GET', url, true);
+    req.timeout = REQUEST_TIMEOUT;
+    if (entry && entry.etag) {
+      req.setRequestHeader('If-None-Match', entry.etag);
+    }
+    req.onload = function() {
+      var bodyChanged = false;
+      if (req.status == 304 && entry) {
+        entry.fetchedAt = Date.now();
+      } else if (req.status >= 200 && req.status < 300) {
+        entry = {
+          body: req.responseText,
+          etag: req.getResponseHeader('ETag'),
+          fetchedAt: Date.now()
+        };
+        bodyChanged = true;
+      } else {
+        console.log('Error: ' + req.status + ' ' + req.statusText);
+        finish(req.status);
+        return;
+      }
+      var data;
+      try {
+        data = parsed(entry);
+      } catch (e) {
+        console.log('Invalid response from ' + url);
+        remove(url);
+        save();
+        finish(-1);
+        return;
+      }
+      touch(url, entry);
+      save(url, bodyChanged);
+      finish(0, data);
+    };
+    req.onerror = function() {
+      finish(-1);
+    };
+    req.ontimeout = function() {
+      console.log('Timed out after ' + REQUEST_TIMEOUT + ' ms: ' + url);
+      finish(-1);
+    };
+    req.send();
+  }
+}
+
+// The callback of the getJSON() that returned waiter is not called any more.
+// The request itself is only dropped once nobody else waits for it either.
+function abort(waiter) {
+  var pending = waiter && inFlight[waiter.url];
+  var index = pending ? pending.waiters.indexOf(waiter) : -1;
+  if (index < 0) {
+    return;
+  }
+  pending.waiters.splice(index, 1);
+  if (pending.waiters.length > 0) {
+    return;
+  }
+  var url = waiter.url;
+  delete inFlight[url];
+  if (pending.req) {
+    pending.req.abort();
+    running--;
+    startNext();
+  } else {
+    waiting.splice(waiting.indexOf(url), 1);
+  }
+}
+
+// Forces the next getJSON() for this URL to go to the server
+function invalidate(url) {
+  if (entries[url]) {
+    entries[url].fetchedAt = 0;
+  }
+}
+
+module.exports = {
+  getJSON: getJSON,
+  abort: abort,
+  invalidate: invalidate
+};
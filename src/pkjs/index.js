@@ -2,13 +2,45 @@ var keys = require('message_keys');
 var apiHost = "https://api.tramlines.de";
 var radius = 5000;
 var quickStartToggle = 0;
+// Seconds between refreshes of the board on screen, 0 turns it off
+var refreshInterval = 120;
 var Clay = require('pebble-clay');
 var clayConfig = require('./config.json');
 var clay = new Clay(clayConfig);
+var cache = require('./cache');
 
-var stationCache = {};
-var stationIdCache;
-var moreInfoCache = {};
+// How long a cached response is used without asking the server again
+var departuresTtl = 30 * 1000;
+var stationsTtl = 10 * 60 * 1000;
+var moreInfoTtl = 30 * 1000;
+
+// After the station list is on the watch we fetch the boards of the nearest
+// stations, so picking one of them is answered straight from the cache
+var prefetchCount = 3;
+var prefetchConcurrency = 2;
+var prefetchQueue = [];
+var prefetching = [];
+
+// Only ask the server for what we send on. Self hosted bahnhof-server
+// versions that don't support the fields parameter ignore it and answer
+// in the full format, which is handled as well. Compression is up to the
+// phone's HTTP stack, gzip'ed responses arrive already decoded.
+var departureFields = "0,2,3,4,5";
+var moreInfoFields = "lineName,destination,platform,timeDelayed,timeSchedule,type,stops";
+
+// The watch opens the biggest inbox its heap allows and tells us the size in
+// INBOX_SIZE. Until it has, assume what every platform has at least.
+var inboxSize = parseInt(localStorage.getItem("INBOX_SIZE"), 10) || 4096;
+
+// The rows the watch has for each station, refreshes are sent as a diff against them
+var watchBoards = {};
+
+// Stations saved in the settings. With any saved, the app starts on one board
+// with the next departures of all of them instead of the nearby stations.
+// That board goes to the watch under this made up station id, refreshes of
+// it fetch and merge the favorites again.
+var favorites = parseFavorites(localStorage.getItem("FAVORITES"));
+var favoritesStationId = -1;
 
 Pebble.addEventListener("ready", function(e) {
   var tempRadius = localStorage.getItem("RADIUS");
@@ -23,8 +55,12 @@ Pebble.addEventListener("ready", function(e) {
   if (tempquickStartToggle) {
     quickStartToggle = tempquickStartToggle;
   }
+  var tempRefreshInterval = localStorage.getItem("REFRESH_INTERVAL");
+  if (tempRefreshInterval !== null) {
+    refreshInterval = parseInt(tempRefreshInterval, 10);
+  }
 
-  navigator.geolocation.getCurrentPosition(success, error, options);
+  startApp();
 });
 
 Pebble.addEventListener("showConfiguration", function(e) {
@@ -48,170 +84,723 @@ Pebble.addEventListener('webviewclosed', function(e) {
   quickStartToggle = dict[keys.QUICK_START_TOGGLE];
   localStorage.setItem("QUICK_START", quickStartToggle);
   console.log('quickStartToggle: ' + quickStartToggle);
+  refreshInterval = parseInt(dict[keys.REFRESH_INTERVAL], 10) || 0;
+  localStorage.setItem("REFRESH_INTERVAL", refreshInterval);
+  var favoritesText = dict[keys.FAVORITES] || '';
+  localStorage.setItem("FAVORITES", favoritesText);
+  favorites = parseFavorites(favoritesText);
+  console.log('favorites: ' + favorites.join(', '));
 
-  navigator.geolocation.getCurrentPosition(success, error, options);
+  startApp();
 });
 
-function success(pos) {
-    console.log('lat= ' + pos.coords.latitude + ' lon= ' + pos.coords.longitude);
-    var lat = pos.coords.latitude;
-    var lon = pos.coords.longitude;
-    // overwrite with test data for either testing or for screenshots
-    //lat = 50.934496;
-    //lon = 6.981107;
-    if (quickStartToggle == 1) {
-      quickStart(lat, lon);
+function startApp() {
+  if (favorites.length > 0) {
+    favoritesStart();
+    return;
+  }
+  locate();
+}
+
+// "8000207, 8000208" or one per line, anything that isn't an id is ignored
+function parseFavorites(text) {
+  return (text || '').split(/[\s,;]+/).map(function(id) {
+    return parseInt(id, 10);
+  }).filter(function(id) {
+    return id > 0;
+  });
+}
+
+function favoritesStart() {
+  // a location fix that is still on its way must not replace the favorites
+  locateGeneration++;
+  loadRows(favoritesStationId, function(status, rows) {
+    if (status != 0) {
+      sendMessage({"NO_INTERNET": 1});
       return;
     }
-    legacyStart(lat, lon);
+    sendRows("STATION_ARRAY", rows, favoritesStationId, 0);
+  });
 }
 
-function error(err) {
-  console.log('location error (' + err.code + '): ' + err.message);
+// All favorites are fetched at once (the cache runs a few in parallel),
+// their departures merged by time. A station that fails is left out, only
+// if all of them fail there is no board. The merged board is cut to what
+// fits in a single message, the next departures come first.
+function loadFavorites(callback) {
+  var boards = [];
+  var pending = favorites.length;
+  favorites.forEach(function(stationId, index) {
+    cache.getJSON(departuresUrl(stationId), departuresTtl, function(status, response) {
+      if (status == 0) {
+        boards[index] = boardRows(response, stationId).map(function(row) {
+          // the same trip can stop at two favorites
+          return {id: stationId + '/' + row.id, fields: row.fields};
+        });
+      }
+      if (--pending > 0) {
+        return;
+      }
+      var rows = [].concat.apply([], boards.filter(Boolean));
+      if (rows.length == 0) {
+        callback(-1);
+        return;
+      }
+      rows.sort(function(a, b) {
+        return a.fields[2] - b.fields[2];
+      });
+      var fitting = packRows(rows.map(function(row) {
+        return row.fields;
+      }), payloadBudget(boardHeader(rows, favoritesStationId, 0)))[0];
+      callback(0, rows.slice(0, fitting));
+    }, true);
+  });
+}
+
+// callback(status, rows) with the rows of a board, see boardRows()
+function loadRows(stationId, callback) {
+  if (stationId == favoritesStationId) {
+    loadFavorites(callback);
+    return;
+  }
+  cache.getJSON(departuresUrl(stationId), departuresTtl, function(status, response) {
+    callback(status, status == 0 ? boardRows(response, stationId) : null);
+  });
 }
 
-var options = {
+// Finding the user is done in tiers, each only if the one before didn't do:
+// a recent position from the last launch is used right away, otherwise a
+// coarse fix (cell/wifi). A high accuracy fix always follows, but only
+// changes what the watch shows if it moves us to another nearest station.
+var positionMaxAge = 10 * 60 * 1000;
+var coarseOptions = {
+  enableHighAccuracy: false,
+  maximumAge: 5 * 60 * 1000,
+  timeout: 5000
+};
+var preciseOptions = {
   enableHighAccuracy: true,
   maximumAge: 10000,
-  timeout: 10000
+  timeout: 15000
 };
+var locateGeneration = 0;
+var nearestStationShown = null;
+// set once the user opened something, a better fix must not pull them back
+var userNavigated = false;
 
-function quickStart(lat, lon) {
-  var url = `${apiHost}/pebble/currentLocation?lat=${lat}&lon=${lon}&radius=${radius}`;
-  var req = new XMLHttpRequest();
-  req.open('GET', url, true);
-  req.onload = function() {
-    if (req.status >= 200 && req.status < 300) {
-      var response = JSON.parse(req.responseText);
-      stationCache = response.departures; // we always cache the last response, because we need it for another request
-      stationIdCache = response.station[2];
-      var departuresArray = response.departures.map(function(departure) {
-        return [
-        departure[2].toString(), // Line
-        departure[3].toString(), // Destination
-        formatTime(departure[4].toString()), // Time
-        departure[5].toString() // Platform
-      ];
-      });
-      // we need to check if the station data will fit in the buffer (uint32_t 4096 (Byte)), 
-      // if not remove the last element until it fits
-      while (JSON.stringify(departuresArray).length > 4000) {
-        departuresArray.pop();
+function locate() {
+  var generation = ++locateGeneration;
+  var started = false;
+  userNavigated = false;
+
+  function current() {
+    return generation == locateGeneration;
+  }
+
+  var cached = JSON.parse(localStorage.getItem("LAST_POSITION") || 'null');
+  if (cached && Date.now() - cached.timestamp < positionMaxAge) {
+    console.log('using position from ' + new Date(cached.timestamp));
+    start(cached.lat, cached.lon, false);
+    started = true;
+  } else {
+    navigator.geolocation.getCurrentPosition(function(pos) {
+      if (current() && !started) {
+        savePosition(pos);
+        start(pos.coords.latitude, pos.coords.longitude, false);
+        started = true;
       }
-      Pebble.sendAppMessage({"STATION_ARRAY": JSON.stringify(departuresArray)});
-    } else {
-      console.log('Error: ' + req.statusText);
-      Pebble.sendAppMessage({"NO_INTERNET": 1});
+    }, function(err) {
+      console.log('coarse location error (' + err.code + '): ' + err.message);
+    }, coarseOptions);
+  }
+
+  navigator.geolocation.getCurrentPosition(function(pos) {
+    if (!current()) {
+      return;
     }
-  };
-  req.onerror = function() {
-    Pebble.sendAppMessage({"NO_INTERNET": 1});
-  };
-  req.send();
+    savePosition(pos);
+    start(pos.coords.latitude, pos.coords.longitude, started);
+    started = true;
+  }, function(err) {
+    console.log('location error (' + err.code + '): ' + err.message);
+    if (current() && !started) {
+      sendMessage({"NO_LOCATION": 1});
+    }
+  }, preciseOptions);
+}
+
+function savePosition(pos) {
+  localStorage.setItem("LAST_POSITION", JSON.stringify({
+    lat: pos.coords.latitude,
+    lon: pos.coords.longitude,
+    timestamp: Date.now()
+  }));
+}
+
+// With refine set, the watch already shows something for an earlier fix and
+// only gets the new result if its nearest station is a different one
+function start(latitude, longitude, refine) {
+  console.log('lat= ' + latitude + ' lon= ' + longitude + (refine ? ' (refine)' : ''));
+  if (refine && userNavigated) {
+    return;
+  }
+  // ~100 m is plenty for "nearby" and lets the response cache hit on the next launch
+  var lat = latitude.toFixed(3);
+  var lon = longitude.toFixed(3);
+  // overwrite with test data for either testing or for screenshots
+  //lat = 50.934496;
+  //lon = 6.981107;
+  if (quickStartToggle == 1) {
+    quickStart(lat, lon, refine);
+    return;
+  }
+  legacyStart(lat, lon, refine);
+}
+
+// Whether a result for nearestStation has to go to the watch
+function showsNewNearest(nearestStation, refine) {
+  if (refine && (userNavigated || nearestStation == nearestStationShown)) {
+    return false;
+  }
+  nearestStationShown = nearestStation;
+  return true;
+}
+
+function currentLocationUrl(lat, lon) {
+  return `${apiHost}/pebble/currentLocation?lat=${lat}&lon=${lon}&radius=${radius}&fields=${departureFields}`;
+}
+
+function quickStart(lat, lon, refine) {
+  cache.getJSON(currentLocationUrl(lat, lon), departuresTtl, function(status, response) {
+    if (status != 0) {
+      if (!refine) {
+        sendMessage({"NO_INTERNET": 1});
+      }
+      return;
+    }
+    if (!showsNewNearest(response.station[2], refine)) {
+      return;
+    }
+    sendDepartures("STATION_ARRAY", response.departures, response.station[2], 0);
+  });
 }
 
 
-function legacyStart(lat, lon) {
+// The nearest station is what most people pick, so its board (from the
+// combined quick start endpoint, fetched alongside the list) goes to the
+// watch right after the list and opens without asking the phone again
+function legacyStart(lat, lon, refine) {
   var url = `${apiHost}/pebble/stations?lat=${lat}&lon=${lon}&radius=${radius}`;
-  var req = new XMLHttpRequest();
-  req.open('GET', url, true);
-  req.onload = function() {
-    if (req.status >= 200 && req.status < 300) {
-      var response = JSON.parse(req.responseText);
-      var stationsArray = response.map(function(station) {
-        return [station[0], station[1].toString(), station[2].toString()];
-      });
-      // we need to check if the station data will fit in the buffer (uint32_t 4096) (it probably will), 
-      // but if not remove the last element until it fit
-      while (JSON.stringify(stationsArray).length > 4000) {
-        stationsArray.pop();
+  var nearestUrl = currentLocationUrl(lat, lon);
+  if (!refine) {
+    cache.getJSON(nearestUrl, departuresTtl, function() {});
+  }
+  cache.getJSON(url, stationsTtl, function(status, response) {
+    if (status != 0) {
+      if (!refine) {
+        sendMessage({"NO_INTERNET": 1});
       }
-      Pebble.sendAppMessage({"STATIONS_ARRAY": JSON.stringify(stationsArray)});
-    } else {
-      console.log('Error: ' + req.statusText);
-      Pebble.sendAppMessage({"NO_INTERNET": 1});
+      return;
     }
-  };
-  req.onerror = function() {
-    Pebble.sendAppMessage({"NO_INTERNET": 1});
-  };
-  req.send();
+    if (!showsNewNearest(response.length > 0 ? response[0][2] : null, refine)) {
+      return;
+    }
+    var stationsArray = response.map(function(station) {
+      return [
+        station[0].toString(), // Name
+        station[1].toString(), // Distance
+        parseInt(station[2], 10) // ID
+      ];
+    });
+    sendMessage({"STATIONS_ARRAY": packRows(stationsArray, payloadBudget({}))});
+    preloadNearestBoard(nearestUrl);
+    prefetchBoards(stationsArray.slice(1).map(function(station) {
+      return station[2];
+    }));
+  });
+}
+
+function preloadNearestBoard(url) {
+  cache.getJSON(url, departuresTtl, function(status, response) {
+    if (status != 0) {
+      return;
+    }
+    sendDepartures("STATION_ARRAY", response.departures, response.station[2], 0, {"BOARD_PRELOAD": 1});
+  });
+}
+
+function prefetchBoards(stationIds) {
+  cancelPrefetch();
+  prefetchQueue = stationIds.slice(0, prefetchCount).map(departuresUrl);
+  for (var i = 0; i < prefetchConcurrency; i++) {
+    prefetchNext();
+  }
+}
+
+function prefetchNext() {
+  var url = prefetchQueue.shift();
+  if (!url) {
+    return;
+  }
+  var fetch = cache.getJSON(url, departuresTtl, function() {
+    prefetching = prefetching.filter(function(other) {
+      return other !== fetch;
+    });
+    prefetchNext();
+  });
+  if (fetch) {
+    prefetching.push(fetch);
+  }
+}
+
+// The user picked a station, so only the board for that one is still useful.
+// A prefetch of it keeps running for whoever else waits for it.
+function cancelPrefetch() {
+  prefetchQueue = [];
+  prefetching.forEach(function(fetch) {
+    cache.abort(fetch);
+  });
+  prefetching = [];
+}
+
+function departuresUrl(stationId) {
+  return `${apiHost}/pebble/current/${stationId}?fields=${departureFields}`;
 }
 
 Pebble.addEventListener("appmessage", function(e) {
   var dict = e.payload;
   console.log('Received message: ' + JSON.stringify(dict));
-  if (dict["GET_STATION"] || dict["GET_STATION_FROM_STOP"]) {
-    var stationId = dict["GET_STATION"] || dict["GET_STATION_FROM_STOP"];
-    var url = `${apiHost}/pebble/current/${stationId}`;
-    var req = new XMLHttpRequest();
-    req.open('GET', url, true);
-    req.onload = function() {
-      if (req.status >= 200 && req.status < 300) {
-        var response = JSON.parse(req.responseText);
-        stationCache = response; // we always cache the last response, because we need it for another request
-        stationIdCache = stationId;
-        var departuresArray = response.map(function(departure) {
-          return [
-          departure[2].toString(), // Line
-          departure[3].toString(), // Destination
-          formatTime(departure[4].toString()), // Time
-          departure[5].toString() // Platform
-        ];
-        });
-        // we need to check if the station data will fit in the buffer (uint32_t 4096 (Byte)), 
-        // if not remove the last element until it fits
-        while (JSON.stringify(departuresArray).length > 4000) {
-          departuresArray.pop();
-        }
-        if (dict["GET_STATION"]) {
-          Pebble.sendAppMessage({"STATION_ARRAY": JSON.stringify(departuresArray)});
-        } else {
-          Pebble.sendAppMessage({"STATION_FROM_STOP": JSON.stringify(departuresArray)});
-        }
+  startTiming(dict["REQUEST_ID"] || 0);
+  if (dict["INBOX_SIZE"] && dict["INBOX_SIZE"] != inboxSize) {
+    inboxSize = dict["INBOX_SIZE"];
+    localStorage.setItem("INBOX_SIZE", inboxSize);
+    console.log('watch inbox: ' + inboxSize + ' bytes');
+  }
+  if (dict["TRACE_DUMP"]) {
+    logTrace(dict["TRACE_DUMP"]);
+    return;
+  }
+  if (dict["REFRESH_STATION"]) {
+    refreshBoard(dict["REFRESH_STATION"], {id: dict["REQUEST_ID"] || 0});
+    return;
+  }
+  if (dict["RELOAD_STATION"]) {
+    refreshBoard(dict["RELOAD_STATION"], {id: dict["REQUEST_ID"] || 0}, true);
+    return;
+  }
+  if (dict["GET_STATION"]) {
+    sendBoard("STATION_ARRAY", dict["GET_STATION"], beginRequest(dict));
+  } else if (dict["GET_STATION_FROM_STOP"]) {
+    sendBoard("STATION_FROM_STOP", dict["GET_STATION_FROM_STOP"], beginRequest(dict));
+  } else if (dict["GET_MORE_INFO"]) {
+    sendMoreInfo(dict["GET_MORE_INFO"], dict["TRIP_ID"], beginRequest(dict));
+  } else if (dict["GET_MORE_INFO_FAVORITES"]) {
+    // a trip on the favorites board, the station is the one it stops at
+    sendMoreInfo(dict["GET_MORE_INFO_FAVORITES"], dict["TRIP_ID"], beginRequest(dict), favoritesStationId);
+  }
+});
+
+// Requests from the watch carry a REQUEST_ID that every answer echoes, so the
+// watch can drop answers to requests it has moved on from. A new request from
+// the user supersedes the one before: its fetch is aborted and its answer is
+// never sent. Refreshes never supersede anything.
+var currentRequest = null;
+
+function beginRequest(dict) {
+  userNavigated = true;
+  if (currentRequest && currentRequest.fetch) {
+    cache.abort(currentRequest.fetch);
+  }
+  currentRequest = {id: dict["REQUEST_ID"] || 0, fetch: null};
+  return currentRequest;
+}
+
+// Fetches url for request, callback only runs if the request is still current
+function fetchFor(request, url, ttl, callback) {
+  var fetch = cache.getJSON(url, ttl, function(status, response) {
+    if (request.fetch === fetch) {
+      request.fetch = null;
+    }
+    logTiming(request.id, 'fetched');
+    if (!isCurrent(request)) {
+      console.log('Dropping answer to superseded request ' + request.id);
+      return;
+    }
+    callback(status, response);
+  }, true);
+  // null if the cache answered right away, the callback has run already
+  if (fetch) {
+    request.fetch = fetch;
+  }
+}
+
+function isCurrent(request) {
+  if (!currentRequest) {
+    return true;
+  }
+  return request === currentRequest || request.id > currentRequest.id;
+}
+
+function reply(request, message) {
+  message["REQUEST_ID"] = request.id;
+  sendMessage(message);
+}
+
+// boardStationId is the board the trip was picked on if that isn't its
+// station's own, the favorites board
+function sendMoreInfo(stationId, tripId, request, boardStationId) {
+  // the watch sends the station and trip of the row, so this works no
+  // matter which board we fetched last
+  var url = `${apiHost}/pebble/moreinfo/${stationId}/${tripId}?fields=${moreInfoFields}`;
+  fetchFor(request, url, moreInfoTtl, function(status, response) {
+    if (status == 404) {
+      // If we get a 404, that means the train has already left and there is no more info.
+      // The watch is waiting anyway, so answer with the refreshed board right away.
+      // The cached board still has that train, so it has to be fetched again
+      cache.invalidate(departuresUrl(stationId));
+      if (boardStationId == favoritesStationId) {
+        sendFavorites(request);
       } else {
-        console.log('Error: ' + req.statusText);
-        Pebble.sendAppMessage({"NO_INTERNET": 1});
+        sendBoard("STATION_ARRAY", stationId, request);
       }
-    };
-    req.onerror = function() {
-      Pebble.sendAppMessage({"NO_INTERNET": 1});
-    };
-    req.send();
-  } else if (dict["GET_MORE_INFO"]) {
-    // we get the uuid from the stationCache
-    var uuid = stationCache[dict["GET_MORE_INFO"] - 1][0];
-    var url = `${apiHost}/pebble/moreinfo/${stationIdCache}/${uuid}`;
-    var req = new XMLHttpRequest();
-    req.open('GET', url, true);
-    req.onload = function() {
-      if (req.status >= 200 && req.status < 300) {
-        var response = JSON.parse(req.responseText);
-        moreInfoCache = response;
-        var moreInfoArray = [
-          response.lineName,
-          response.destination,
-          response.platform.toString(),
-          formatTime(response.timeDelayed),
-          getDelayDifference(response.timeDelayed, response.timeSchedule).toString(),
-          response.type,
-        ];
-        var stops = response.stops;
-        Pebble.sendAppMessage({"MORE_INFO": JSON.stringify(moreInfoArray)});
-        //console.log(JSON.stringify(stops));
-        Pebble.sendAppMessage({"STOPS_MORE_INFO": JSON.stringify(stops)});
-      } else if (req.status == 404) {
-        // If we get a 404, that means the train has already left and there is no more info
-        // In that case we send MORE_INFO_TIMEOUT with the value being the stationId
-        Pebble.sendAppMessage({"MORE_INFO_TIMEOUT": stationIdCache});
+      return;
+    } else if (status == -1) {
+      reply(request, {"NO_INTERNET": 1});
+      return;
+    } else if (status != 0) {
+      return;
+    }
+    var moreInfoArray = [
+      response.lineName,
+      response.destination,
+      response.platform.toString(),
+      formatTime(response.timeDelayed),
+      getDelayDifference(response.timeDelayed, response.timeSchedule).toString(),
+      response.type,
+    ];
+    var stops = response.stops.map(function(stop) {
+      return [parseInt(stop[0], 10), stop[1].toString()];
+    });
+    reply(request, {"MORE_INFO": packRows([moreInfoArray], payloadBudget({"REQUEST_ID": 0}))});
+    //console.log(JSON.stringify(stops));
+    reply(request, {"STOPS_MORE_INFO": packRows(stops, payloadBudget({"REQUEST_ID": 0}))});
+  });
+}
+
+// AppMessages go out one at a time, the next one only after the watch ACKed
+// the last, so back to back messages and board chunks never hit a busy inbox
+var messageQueue = [];
+var messageInFlight = false;
+var messageRetries = 0;
+
+// Every stage of a request is logged as "[timing] <request id> <stage> <ms>",
+// the ms counted from the watch's request (or app start for what the phone
+// sends on its own), so per stage latency and bytes can be read from the logs
+var launchedAt = Date.now();
+var requestStarts = {};
+
+function startTiming(requestId) {
+  requestStarts[requestId] = Date.now();
+  Object.keys(requestStarts).forEach(function(id) {
+    if (Date.now() - requestStarts[id] > 60 * 1000) {
+      delete requestStarts[id];
+    }
+  });
+}
+
+function logTiming(requestId, stage) {
+  var startedAt = requestId == 0 ? launchedAt : requestStarts[requestId];
+  if (startedAt) {
+    console.log('[timing] ' + requestId + ' ' + stage + ' ' + (Date.now() - startedAt));
+  }
+}
+
+// The watch's trace (modules/trace.c): [row count] and per row ms since
+// launch, event, value and heap used, all little endian int32
+var traceEvents = ['outbox send', 'inbox received', 'parse start', 'parse end', 'window load', 'first draw'];
+
+function logTrace(bytes) {
+  function readInt32(offset) {
+    return bytes[offset] | (bytes[offset + 1] << 8) | (bytes[offset + 2] << 16) | (bytes[offset + 3] << 24);
+  }
+  for (var row = 0; row < bytes[0]; row++) {
+    var offset = 1 + row * 16;
+    console.log('[trace] ' + readInt32(offset) + ' ms ' + traceEvents[readInt32(offset + 4)] + ' ' +
+                readInt32(offset + 8) + ', heap ' + readInt32(offset + 12));
+  }
+}
+
+// The key of the payload, not one of the numbers that go with it
+function messageName(message) {
+  var keys = Object.keys(message);
+  return keys.filter(function(key) {
+    return typeof message[key] !== 'number';
+  })[0] || keys[0];
+}
+
+// What a message costs on the wire: a 7 byte header per tuple and its value
+function messageBytes(message) {
+  var bytes = 1;
+  Object.keys(message).forEach(function(key) {
+    var value = message[key];
+    bytes += 7 + (typeof value === 'number' ? 4 : value.length + (typeof value === 'string' ? 1 : 0));
+  });
+  return bytes;
+}
+
+function sendMessage(message) {
+  messageQueue.push(message);
+  sendNextMessage();
+}
+
+function sendNextMessage() {
+  if (messageInFlight || messageQueue.length == 0) {
+    return;
+  }
+  messageInFlight = true;
+  var sentAt = Date.now();
+  Pebble.sendAppMessage(messageQueue[0], function() {
+    var message = messageQueue.shift();
+    logTiming(message["REQUEST_ID"] || 0, 'acked ' + messageName(message) + ' ' +
+              messageBytes(message) + ' B in ' + (Date.now() - sentAt));
+    messageInFlight = false;
+    messageRetries = 0;
+    sendNextMessage();
+  }, function(e) {
+    messageInFlight = false;
+    messageRetries++;
+    if (messageRetries > 3) {
+      console.log('Dropping message after ' + messageRetries + ' tries');
+      messageQueue.shift();
+      messageRetries = 0;
+    }
+    setTimeout(sendNextMessage, 250 * messageRetries);
+  });
+}
+
+function sendBoard(key, stationId, request) {
+  fetchFor(request, departuresUrl(stationId), departuresTtl, function(status, response) {
+    if (status != 0) {
+      reply(request, {"NO_INTERNET": 1});
+      return;
+    }
+    sendDepartures(key, response, stationId, request.id);
+  });
+  // after we joined a prefetch of this board, so it keeps running
+  cancelPrefetch();
+}
+
+function sendFavorites(request) {
+  loadRows(favoritesStationId, function(status, rows) {
+    if (!isCurrent(request)) {
+      return;
+    }
+    if (status != 0) {
+      reply(request, {"NO_INTERNET": 1});
+      return;
+    }
+    sendRows("STATION_ARRAY", rows, favoritesStationId, request.id);
+  });
+}
+
+// full: the watch went back to a board it kept or dropped rows we sent it,
+// it has no idea which rows we diffed against since and gets the whole board
+function refreshBoard(stationId, request, full) {
+  loadRows(stationId, function(status, rows) {
+    // A failed refresh keeps the board the watch already has
+    if (status != 0 || !isCurrent(request)) {
+      return;
+    }
+    if (full || !watchBoards[stationId]) {
+      sendRows("STATION_ARRAY", rows, stationId, request.id, {"BOARD_UPDATE": 1});
+      return;
+    }
+    var ops = diffBoards(watchBoards[stationId], rows);
+    if (ops.length == 0) {
+      return;
+    }
+    var delta = packRows(ops, payloadBudget({"REQUEST_ID": 0, "STATION_ID": 0}));
+    if (delta[0] < ops.length) {
+      // too much changed for one message, the whole board is cheaper anyway
+      sendRows("STATION_ARRAY", rows, stationId, request.id, {"BOARD_UPDATE": 1});
+      return;
+    }
+    watchBoards[stationId] = rows;
+    // the watch only applies it to the board of this station
+    reply(request, {"STATION_DELTA": delta, "STATION_ID": parseInt(stationId, 10) || 0});
+  });
+}
+
+var deltaUpdate = 0;
+var deltaInsert = 1;
+var deltaRemove = 2;
+
+// Turns the old rows into the new ones with [op, index, ...fields] steps the
+// watch applies in order. Rows are matched by trip id, so a delayed train is
+// an update of its row and not a remove and insert.
+function diffBoards(oldRows, newRows) {
+  var ops = [];
+  var newIds = {};
+  newRows.forEach(function(row) {
+    newIds[row.id] = true;
+  });
+  var current = oldRows.slice();
+  for (var i = current.length - 1; i >= 0; i--) {
+    if (!newIds[current[i].id]) {
+      ops.push([deltaRemove, i, '', '', 0, '', '', 0]);
+      current.splice(i, 1);
+    }
+  }
+  newRows.forEach(function(row, index) {
+    var existing = current[index];
+    if (existing && existing.id == row.id) {
+      if (existing.fields.join('\n') != row.fields.join('\n')) {
+        ops.push([deltaUpdate, index].concat(row.fields));
+        current[index] = row;
       }
+      return;
+    }
+    // the row moved (or is new), take it out where it was and put it here
+    for (var j = index + 1; j < current.length; j++) {
+      if (current[j].id == row.id) {
+        ops.push([deltaRemove, j, '', '', 0, '', '', 0]);
+        current.splice(j, 1);
+        break;
+      }
+    }
+    ops.push([deltaInsert, index].concat(row.fields));
+    current.splice(index, 0, row);
+  });
+  return ops;
+}
+
+// Servers that know the fields parameter send just trip id, line,
+// destination, time and platform, older ones the full rows
+function compactDeparture(departure) {
+  if (departure.length > 5) {
+    return [departure[0], departure[2], departure[3], departure[4], departure[5]];
+  }
+  return departure;
+}
+
+function boardRows(departures, stationId) {
+  return departures.map(function(fullDeparture) {
+    var departure = compactDeparture(fullDeparture);
+    return {
+      id: departure[0],
+      fields: [
+        departure[1].toString(), // Line
+        departure[2].toString(), // Destination
+        epochSeconds(departure[3]), // Time, the watch counts down to it
+        departure[4].toString(), // Platform
+        departure[0].toString(), // Trip id
+        parseInt(stationId, 10) || 0
+      ]
     };
-    req.onerror = function() {
-      Pebble.sendAppMessage({"NO_INTERNET": 1});
-    };
-    req.send();
+  });
+}
+
+function sendDepartures(key, departures, stationId, requestId, flags) {
+  sendRows(key, boardRows(departures, stationId), stationId, requestId, flags);
+}
+
+// What the first chunk of a board carries besides the rows
+function boardHeader(rows, stationId, requestId) {
+  return {
+    "CHUNK_INDEX": 0,
+    "REQUEST_ID": requestId,
+    "BOARD_ROWS": rows.length,
+    "STATION_ID": parseInt(stationId, 10) || 0,
+    "REFRESH_INTERVAL": refreshInterval
+  };
+}
+
+// Big boards (Köln Hbf...) don't fit in one message, so they are split into
+// chunks. The first one tells the watch how many rows the board has, the
+// watch shows it right away and appends the others as they arrive.
+// flags go into the first chunk: BOARD_PRELOAD for a board the watch keeps
+// until the station is picked, BOARD_UPDATE for a refresh that must only
+// replace the board the watch has and never open it again.
+function sendRows(key, rows, stationId, requestId, flags) {
+  watchBoards[stationId] = rows;
+  var departuresArray = rows.map(function(row) {
+    return row.fields;
+  });
+  var first = boardHeader(rows, stationId, requestId);
+  Object.keys(flags || {}).forEach(function(flag) {
+    first[flag] = flags[flag];
+  });
+  // the first chunk carries more besides the rows than the others
+  var chunks = packChunks(departuresArray, payloadBudget({"CHUNK_INDEX": 0, "REQUEST_ID": 0}), payloadBudget(first));
+  chunks.forEach(function(chunk, index) {
+    var message = index == 0 ? first : {"CHUNK_INDEX": index, "REQUEST_ID": requestId};
+    message[key] = chunk;
+    sendMessage(message);
+  });
+}
+
+// How many bytes of rows fit next to the other tuples of a message
+function payloadBudget(otherTuples) {
+  return inboxSize - messageBytes(otherTuples) - 7;
+}
+
+// Everything we send to the watch is a byte array instead of a JSON string:
+// [row count] and then every field of every row, strings as
+// [length][UTF-8 bytes][0] and numbers as little endian int32.
+// The watch reads that in a single pass (modules/payload.c) and uses the
+// strings in place. Every row is encoded once and goes into the first
+// chunk that still has room for it.
+function packChunks(rows, maxBytes, firstMaxBytes) {
+  var chunks = [];
+  var chunk = [0];
+  var chunkMaxBytes = firstMaxBytes || maxBytes;
+  rows.forEach(function(fields) {
+    var row = [];
+    fields.forEach(function(field) {
+      if (typeof field === 'number') {
+        appendInt32(row, field);
+      } else {
+        appendString(row, field);
+      }
+    });
+    if (chunk[0] > 0 && (chunk[0] == 255 || chunk.length + row.length > chunkMaxBytes)) {
+      chunks.push(chunk);
+      chunk = [0];
+      chunkMaxBytes = maxBytes;
+    }
+    Array.prototype.push.apply(chunk, row);
+    chunk[0]++;
+  });
+  chunks.push(chunk);
+  return chunks;
+}
+
+// Single message payloads, rows that don't fit are left out
+function packRows(rows, maxBytes) {
+  return packChunks(rows, maxBytes)[0];
+}
+
+function appendString(bytes, str) {
+  var utf8 = unescape(encodeURIComponent(str == null ? '' : str.toString()));
+  var len = Math.min(utf8.length, 254);
+  // don't cut a multi byte character (ä, ö, ü, ß...) in half
+  while (len < utf8.length && (utf8.charCodeAt(len) & 0xC0) == 0x80) {
+    len--;
   }
-});
+  bytes.push(len);
+  for (var i = 0; i < len; i++) {
+    bytes.push(utf8.charCodeAt(i));
+  }
+  bytes.push(0);
+}
+
+function appendInt32(bytes, value) {
+  bytes.push(value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, (value >> 24) & 0xFF);
+}
+
+function epochSeconds(time) {
+  return Math.floor(new Date(time).getTime() / 1000);
+}
 
 function formatTime(time) {
   // format is YYYY-MM-DDTHH:MM:SS+00:00
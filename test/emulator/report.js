@@ -0,0 +1,101 @@
+// Turns the logs of run.sh into a markdown report, one row per platform:
+//
+//   node report.js <commit> reports/<commit>/aplite.log ...
+//
+// Time to first render is read from the watch's trace: from the click's
+// request (the first outbox send after the screen before) to the first draw
+// of the next screen, for the list from the launch. Bytes are what the
+// phone's "[timing] ... acked" lines say went over AppMessage.
+var fs = require('fs');
+var path = require('path');
+
+var commit = process.argv[2];
+var logs = process.argv.slice(3);
+
+// Same order as TraceWindow in src/c/modules/trace.h
+var screenNames = ['list', 'board', 'trip'];
+var columns = ['list', 'board', 'trip', 'stop board'];
+
+function parse(text) {
+  var events = {};
+  var bytes = {};
+  var messages = 0;
+  text.split('\n').forEach(function(line) {
+    var match;
+    if ((match = /\[trace\] (-?\d+) ms (.+?) (-?\d+), heap (\d+)/.exec(line))) {
+      // both dumps have the rows in between, keep them once
+      events[match[1] + ' ' + match[2] + ' ' + match[3]] = {
+        ms: parseInt(match[1], 10),
+        event: match[2],
+        value: parseInt(match[3], 10),
+        heap: parseInt(match[4], 10)
+      };
+    } else if ((match = /\[timing\] \d+ acked (\S+) (\d+) B/.exec(line))) {
+      bytes[match[1]] = (bytes[match[1]] || 0) + parseInt(match[2], 10);
+      messages++;
+    }
+  });
+  return {
+    events: Object.keys(events).map(function(key) {
+      return events[key];
+    }).sort(function(a, b) {
+      return a.ms - b.ms;
+    }),
+    bytes: bytes,
+    messages: messages
+  };
+}
+
+function screens(events) {
+  var renders = [];
+  var requestAt = 0;
+  var waiting = true;
+  var boards = 0;
+  events.forEach(function(event) {
+    if (event.event == 'outbox send' && !waiting) {
+      requestAt = event.ms;
+      waiting = true;
+    } else if (event.event == 'first draw') {
+      var name = screenNames[event.value];
+      if (name == 'board' && boards++ > 0) {
+        name = 'stop board';
+      }
+      renders.push({name: name, ms: event.ms - requestAt});
+      waiting = false;
+    }
+  });
+  return renders;
+}
+
+console.log('# Emulator benchmark ' + commit);
+console.log('');
+console.log('Time to first render in ms, AppMessage bytes and messages, heap peak in bytes.');
+console.log('');
+console.log('| platform | ' + columns.join(' | ') + ' | bytes | messages | heap peak |');
+console.log('|' + ' --- |'.repeat(columns.length + 4));
+var details = [];
+logs.forEach(function(log) {
+  var platform = path.basename(log, '.log');
+  var run = parse(fs.readFileSync(log, 'utf8'));
+  var renders = screens(run.events);
+  var cells = columns.map(function(column) {
+    var render = renders.filter(function(other) {
+      return other.name == column;
+    })[0];
+    return render ? render.ms : '-';
+  });
+  var total = Object.keys(run.bytes).reduce(function(sum, key) {
+    return sum + run.bytes[key];
+  }, 0);
+  var heapPeak = run.events.reduce(function(peak, event) {
+    return Math.max(peak, event.heap);
+  }, 0);
+  console.log('| ' + [platform].concat(cells, [total, run.messages, heapPeak || '-']).join(' | ') + ' |');
+  details.push('- ' + platform + ': ' + Object.keys(run.bytes).map(function(key) {
+    return key + ' ' + run.bytes[key];
+  }).join(', '));
+});
+console.log('');
+console.log('Bytes by message:');
+console.log('');
+console.log(details.join('\n'));
@@ -0,0 +1,113 @@
+#!/bin/sh
+# End to end benchmark in the Pebble emulator against the mock server:
+#
+#   test/emulator/run.sh [platform...]
+#
+# Builds a copy of the app with shim.js in front of the phone code, starts
+# test/mock-server and then, on every platform (all five by default):
+# launch -> station list -> second station's board -> first trip's details
+# -> board of its second stop. The watch's trace is dumped from the first
+# and the last board. Everything the app logs goes to
+# test/emulator/reports/<commit>/<platform>.log, report.js turns the logs
+# into report.md there: time to first render per screen, AppMessage bytes
+# and the heap peak. Needs the Pebble SDK (pebble) and node.
+#
+# MOCK_PORT (8080) and MOCK_ARGS (e.g. "--latency=300 --jitter=200") go to
+# the mock server, STEP_TIMEOUT (30) is how long each screen may take.
+set -e
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+HERE=$ROOT/test/emulator
+PLATFORMS=${*:-aplite basalt chalk diorite emery}
+MOCK_PORT=${MOCK_PORT:-8080}
+STEP_TIMEOUT=${STEP_TIMEOUT:-30}
+COMMIT=$(git -C "$ROOT" rev-parse --short HEAD)$(git -C "$ROOT" diff --quiet HEAD -- src || echo -dirty)
+OUT=$HERE/reports/$COMMIT
+BUILD=$(mktemp -d)
+mkdir -p "$OUT"
+
+cp -R "$ROOT/package.json" "$ROOT/wscript" "$ROOT/src" "$ROOT/resources" "$BUILD"
+[ -d "$ROOT/node_modules" ] && cp -R "$ROOT/node_modules" "$BUILD"
+{ sed "s/MOCK_PORT/$MOCK_PORT/" "$HERE/shim.js"; cat "$ROOT/src/pkjs/index.js"; } > "$BUILD/src/pkjs/index.js"
+(cd "$BUILD" && pebble build)
+
+node "$ROOT/test/mock-server/server.js" --port="$MOCK_PORT" $MOCK_ARGS > "$OUT/mock-server.log" 2>&1 &
+MOCK=$!
+LOGS=
+cleanup() {
+  [ -n "$LOGS" ] && kill "$LOGS" 2>/dev/null
+  kill "$MOCK" 2>/dev/null
+  pebble kill 2>/dev/null || true
+  rm -rf "$BUILD"
+}
+trap cleanup EXIT
+
+# An answer to a click, the preload at launch has request id 0
+ANSWER="\[timing\] [1-9][0-9]*"
+
+# How often pattern is in the log so far
+seen() {
+  grep -c -- "$1" "$LOG" 2>/dev/null || true
+}
+
+# Waits until pattern shows up once more than before the last step
+await() {
+  before=$1
+  pattern=$2
+  waited=0
+  while [ "$(seen "$pattern")" -le "$before" ]; do
+    if [ "$waited" -ge "$STEP_TIMEOUT" ]; then
+      echo "$PLATFORM: no '$pattern' after ${STEP_TIMEOUT}s" >&2
+      return 1
+    fi
+    sleep 1
+    waited=$((waited + 1))
+  done
+  # let the screen draw before the next click
+  sleep 1
+}
+
+button() {
+  pebble emu-button --emulator "$PLATFORM" click "$@"
+}
+
+# Clicks, then waits for what the phone sends back
+step() {
+  pattern=$1
+  shift
+  before=$(seen "$pattern")
+  for click in "$@"; do
+    button $click
+  done
+  await "$before" "$pattern"
+}
+
+# A long press on a board sends the trace to the phone log
+dump_trace() {
+  before=$(seen "\[trace\]")
+  button select --duration 1000
+  await "$before" "\[trace\]"
+}
+
+for PLATFORM in $PLATFORMS; do
+  LOG=$OUT/$PLATFORM.log
+  : > "$LOG"
+  pebble kill 2>/dev/null || true
+  # Keeps streaming the logs after the install, from the first line on
+  (cd "$BUILD" && pebble install --emulator "$PLATFORM" --logs > "$LOG" 2>&1) &
+  LOGS=$!
+  if await 0 "acked STATIONS_ARRAY" &&
+     step "$ANSWER acked STATION_ARRAY" down select &&
+     dump_trace &&
+     step "$ANSWER acked STOPS_MORE_INFO" select &&
+     step "$ANSWER acked STATION_FROM_STOP" down down select &&
+     dump_trace; then
+    echo "$PLATFORM: done"
+  else
+    echo "$PLATFORM: incomplete, see $LOG" >&2
+  fi
+  kill "$LOGS" 2>/dev/null || true
+  LOGS=
+done
+
+node "$HERE/report.js" "$COMMIT" $(for p in $PLATFORMS; do echo "$OUT/$p.log"; done) > "$OUT/report.md"
+cat "$OUT/report.md"
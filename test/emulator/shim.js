@@ -0,0 +1,13 @@
+// Put in front of src/pkjs/index.js by run.sh, never shipped. Every run
+// starts cold, in legacy mode, at a fixed position in Köln, and talks to
+// the mock server.
+localStorage.setItem("API_HOST", "http://localhost:MOCK_PORT");
+localStorage.setItem("QUICK_START", "0");
+localStorage.setItem("FAVORITES", "");
+localStorage.removeItem("LAST_POSITION");
+localStorage.removeItem("RESPONSE_CACHE_INDEX");
+navigator.geolocation.getCurrentPosition = function(success) {
+  setTimeout(function() {
+    success({coords: {latitude: 50.943, longitude: 6.959, accuracy: 20}, timestamp: Date.now()});
+  }, 0);
+};
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Records fixtures from a bahnhof-server, the public one by default:
+#
+#   LAT=50.943 LON=6.959 test/fixtures/record.sh [api host] [station id...]
+#
+# Every station's board goes to current/<id>.json in the full format (no
+# fields parameter), so the fixtures work for old and new clients alike.
+# With LAT and LON set, the stations around there go to stations.json.
+# The mock server (test/mock-server) builds the trip details from the
+# boards and stops.json.
+#
+# The fixtures checked in are synthetic: written by hand after real boards
+# of these stations, because they had to be made without network access.
+# Run this against a live server to replace them with recorded ones.
+set -e
+cd "$(dirname "$0")"
+HOST=${1:-https://api.tramlines.de}
+[ $# -gt 0 ] && shift
+STATIONS=${*:-8000207 8000044 8003368}
+
+# One row per line, so a re-recording diffs nicely
+pretty() {
+  node -e '
+    var data = JSON.parse(require("fs").readFileSync(0, "utf8"));
+    console.log("[\n" + data.map(function(row) { return "  " + JSON.stringify(row); }).join(",\n") + "\n]");
+  '
+}
+
+if [ -n "$LAT" ] && [ -n "$LON" ]; then
+  curl -fsS "$HOST/pebble/stations?lat=$LAT&lon=$LON&radius=5000" | pretty > stations.json
+  echo stations.json
+fi
+mkdir -p current
+for id in $STATIONS; do
+  curl -fsS "$HOST/pebble/current/$id" | pretty > "current/$id.json"
+  echo "current/$id.json"
+done
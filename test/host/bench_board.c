@@ -0,0 +1,224 @@
+#include "pack.h"
+// The board code itself, with its drawing stubbed out (pebble_ui_stub.c)
+// and the modules it calls besides the rows in station_window_stubs.c
+#include "../../src/c/windows/station_window.c"
+
+// Receives recorded boards (see ../fixtures and pack_fixture.js) through
+// station_window.c, chunked to the inbox of each platform like the phone
+// does, then applies a refresh delta to them. Prints parse time,
+// allocations and the heap peak per platform and board. Exits with 1 if a
+// board ends up without rows on any platform, aplite's 24 KB included.
+#define BENCH_MIN_NS 100000000LL
+// What the tuples next to the rows take, see payloadBudget() in index.js
+#define FIRST_CHUNK_OVERHEAD 96
+#define CHUNK_OVERHEAD 40
+#define OUTBOX_SIZE 256
+#define MAX_CHUNKS 32
+#define MAX_CHUNK_SIZE 8192
+// Like a refresh a minute later: the first rows delayed, see diffBoards() in index.js
+#define DELTA_ROWS 20
+#define BENCH_STATION_ID 8000207
+#define BENCH_REQUEST_ID 1
+
+typedef struct {
+  const char *name;
+  size_t heap_size;
+  uint32_t inbox_size;
+} Profile;
+
+// App heap and the inbox main.c opens on each platform
+static const Profile s_profiles[] = {
+  { "aplite", 24 * 1024, 4096 },
+  { "basalt", 64 * 1024, 8192 },
+  { "chalk", 64 * 1024, 8192 },
+  { "diorite", 64 * 1024, 8192 },
+  { "emery", 128 * 1024, 8192 },
+};
+
+// A chunk as it sits in the inbox, the rows right behind the tuple header
+typedef struct {
+  union {
+    Tuple tuple;
+    uint8_t bytes[sizeof(Tuple) + MAX_CHUNK_SIZE];
+  };
+} Chunk;
+
+typedef struct {
+  Chunk chunks[MAX_CHUNKS];
+  int num_chunks;
+  int total_rows;
+  int total_length;
+  Chunk delta;
+} BenchBoard;
+
+static long long now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint8_t *read_file(const char *path, uint16_t *length) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return NULL;
+  }
+  static uint8_t buffer[65536];
+  *length = fread(buffer, 1, sizeof(buffer), file);
+  fclose(file);
+  return buffer;
+}
+
+static void set_tuple(Chunk *chunk, uint32_t key, const uint8_t *data, uint16_t length) {
+  chunk->tuple.key = key;
+  chunk->tuple.type = TUPLE_BYTE_ARRAY;
+  chunk->tuple.length = length;
+  memcpy(chunk->tuple.value->data, data, length);
+}
+
+// Splits the board like the phone does, whole rows up to the budget of each message
+static bool chunk_board(BenchBoard *board, uint8_t *data, uint16_t length, const Profile *profile) {
+  static uint8_t rest[65536];
+  PayloadReader reader;
+  payload_reader_init(&reader, data, length);
+  int remaining_rows = payload_read_uint8(&reader);
+  memcpy(rest + 1, reader.ptr, payload_reader_remaining(&reader));
+  uint16_t rest_length = payload_reader_remaining(&reader) + 1;
+  uint8_t *rows_start = rest + 1;
+
+  board->num_chunks = 0;
+  board->total_rows = remaining_rows;
+  board->total_length = 0;
+  while (remaining_rows > 0) {
+    if (board->num_chunks == MAX_CHUNKS) {
+      return false;
+    }
+    uint16_t budget = profile->inbox_size - (board->num_chunks == 0 ? FIRST_CHUNK_OVERHEAD : CHUNK_OVERHEAD);
+    uint8_t rows;
+    rows_start[-1] = remaining_rows;
+    uint16_t chunk_length = payload_fit_rows(rows_start - 1, rest_length, STATION_ROW_FORMAT, budget, &rows);
+    if (rows == 0) {
+      return false;
+    }
+    rows_start[-1] = rows;
+    set_tuple(&board->chunks[board->num_chunks], MESSAGE_KEY_STATION_ARRAY, rows_start - 1, chunk_length);
+    board->total_length += chunk_length - 1;
+    rows_start += chunk_length - 1;
+    rest_length -= chunk_length - 1;
+    remaining_rows -= rows;
+    board->num_chunks++;
+  }
+  return true;
+}
+
+// What app_message.c does with the chunks of a board. The board stays
+// allocated until the next one, like a board that was never pushed.
+static Board *receive_board(BenchBoard *board) {
+  station_window_set_station(&board->chunks[0].tuple, board->total_rows, BENCH_STATION_ID, BENCH_REQUEST_ID);
+  for (int i = 1; i < board->num_chunks; i++) {
+    station_window_append_station(&board->chunks[i].tuple, i, BENCH_REQUEST_ID);
+  }
+  return s_board;
+}
+
+static void drop_board() {
+  if (s_board) {
+    board_destroy(s_board);
+  }
+}
+
+// UPDATE rows for the first departures of the board, each five minutes later
+static void build_delta(BenchBoard *board, Board *received) {
+  static uint8_t buffer[MAX_CHUNK_SIZE];
+  Packer packer;
+  pack_init(&packer, buffer, sizeof(buffer));
+  int count = received->num_stations < DELTA_ROWS ? received->num_stations : DELTA_ROWS;
+  pack_uint8(&packer, count);
+  for (int i = 0; i < count; i++) {
+    Departure *departure = &received->departures[i];
+    pack_int32(&packer, STATION_DELTA_UPDATE);
+    pack_int32(&packer, i);
+    pack_string(&packer, departure->line);
+    pack_string(&packer, departure->destination);
+    pack_int32(&packer, departure->departs_at + 5 * 60);
+    pack_string(&packer, departure->platform);
+    pack_string(&packer, departure->trip_id);
+    pack_int32(&packer, departure->station_id);
+  }
+  set_tuple(&board->delta, MESSAGE_KEY_STATION_DELTA, buffer, packer.length);
+}
+
+// Returns false if the board got no rows
+static bool bench(const char *name, uint8_t *data, uint16_t length, const Profile *profile) {
+  static BenchBoard board;
+  if (!chunk_board(&board, data, length, profile)) {
+    printf("%-8s %-10s does not chunk\n", profile->name, name);
+    return false;
+  }
+  // What is left of the heap once the AppMessage buffers are allocated
+  size_t heap_size = profile->heap_size - profile->inbox_size - OUTBOX_SIZE;
+  host_heap_reset(heap_size);
+  Board *received = receive_board(&board);
+  int rows = received ? received->num_stations : 0;
+  if (received) {
+    build_delta(&board, received);
+    station_window_apply_delta(&board.delta.tuple, BENCH_STATION_ID);
+  }
+  HostHeapStats stats = host_heap_stats();
+  drop_board();
+
+  long long iterations = 0;
+  long long start = now_ns();
+  long long elapsed;
+  do {
+    receive_board(&board);
+    drop_board();
+    iterations++;
+  } while ((elapsed = now_ns() - start) < BENCH_MIN_NS);
+
+  long long delta_iterations = 0;
+  long long delta_elapsed = 0;
+  if (rows > 0) {
+    receive_board(&board);
+    start = now_ns();
+    do {
+      station_window_apply_delta(&board.delta.tuple, BENCH_STATION_ID);
+      delta_iterations++;
+    } while ((delta_elapsed = now_ns() - start) < BENCH_MIN_NS);
+    drop_board();
+  }
+
+  printf("%-8s %-10s %4d/%-4d %6d %3d %9.4f %9.4f %6u %8zu %8zd%s%s\n", profile->name, name, rows, board.total_rows,
+         board.total_length, board.num_chunks, elapsed / 1e6 / iterations,
+         delta_iterations ? delta_elapsed / 1e6 / delta_iterations : 0.0, stats.allocations, stats.peak,
+         (ssize_t)heap_size - (ssize_t)stats.peak, stats.failed ? " out of heap" : "", rows == 0 ? " NO ROWS" : "");
+  return rows > 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s board.bin...\n", argv[0]);
+    return 1;
+  }
+  if (sizeof(void *) != 4) {
+    printf("Pointers are %d bytes here and 4 on the watch, row arrays take more heap (make M32=1)\n",
+           (int)sizeof(void *));
+  }
+  printf("%-8s %-10s %9s %6s %3s %9s %9s %6s %8s %8s\n", "platform", "board", "rows", "bytes", "msg",
+         "ms/board", "ms/delta", "allocs", "peak", "left");
+  bool all_shown = true;
+  for (int i = 1; i < argc; i++) {
+    uint16_t length;
+    uint8_t *data = read_file(argv[i], &length);
+    if (!data) {
+      fprintf(stderr, "cannot read %s\n", argv[i]);
+      return 1;
+    }
+    static uint8_t copy[65536];
+    const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+    for (size_t p = 0; p < sizeof(s_profiles) / sizeof(s_profiles[0]); p++) {
+      memcpy(copy, data, length);
+      all_shown &= bench(name, copy, length, &s_profiles[p]);
+    }
+  }
+  return all_shown ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+#include "pack.h"
+#include "payload.h"
+
+// Parses the same board as packed rows and as the JSON string the watch
+// used to get, with the scanner every window had its own copy of before
+// the shared reader. Prints bytes/ms for both.
+#define BENCH_ROWS 60
+#define BENCH_MIN_NS 200000000LL
+
+static const char *s_lines[] = { "S 12", "RE 5", "STR 18", "ICE 123", "Bus 132", "STR 1", "RB 25", "S 19" };
+static const char *s_destinations[] = {
+  "Köln-Mülheim Wiener Platz", "Bonn Hbf", "Düsseldorf Flughafen Terminal",
+  "Bergisch Gladbach", "Aachen Hbf", "Frankfurt(Main)Hbf", "Weiden West", "Thielenbruch",
+};
+
+typedef struct {
+  const char *line;
+  const char *destination;
+  int32_t departs_at;
+  const char *platform;
+  const char *trip_id;
+  int32_t station_id;
+} Row;
+
+static long long now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint16_t build_packed(uint8_t *buffer, uint16_t capacity, char trip_ids[][24], char platforms[][4]) {
+  Packer packer;
+  pack_init(&packer, buffer, capacity);
+  pack_uint8(&packer, BENCH_ROWS);
+  for (int i = 0; i < BENCH_ROWS; i++) {
+    pack_string(&packer, s_lines[i % 8]);
+    pack_string(&packer, s_destinations[(i * 3) % 8]);
+    pack_int32(&packer, 1760000000 + i * 90);
+    pack_string(&packer, platforms[i]);
+    pack_string(&packer, trip_ids[i]);
+    pack_int32(&packer, 8000207);
+  }
+  return packer.overflow ? 0 : packer.length;
+}
+
+// What the phone sent before user-001: [["line","destination","12:34","2"],...]
+static size_t build_json(char *buffer, size_t capacity, char platforms[][4]) {
+  size_t length = snprintf(buffer, capacity, "[");
+  for (int i = 0; i < BENCH_ROWS && length < capacity; i++) {
+    int minutes = i * 90 / 60;
+    length += snprintf(buffer + length, capacity - length, "%s[\"%s\",\"%s\",\"%02d:%02d\",\"%s\"]",
+                       i ? "," : "", s_lines[i % 8], s_destinations[(i * 3) % 8],
+                       12 + minutes / 60, minutes % 60, platforms[i]);
+  }
+  length += snprintf(buffer + length, capacity - length, "]");
+  return length;
+}
+
+static int parse_packed(uint8_t *data, uint16_t length, Row *rows, uint8_t *copy) {
+  PayloadReader reader;
+  payload_reader_init(&reader, data, length);
+  int count = payload_read_uint8(&reader);
+  // station_window keeps the strings in place in its arena
+  payload_reader_copy_to(&reader, copy);
+  int parsed = 0;
+  for (; parsed < count; parsed++) {
+    Row *row = &rows[parsed];
+    row->line = payload_read_string(&reader);
+    row->destination = payload_read_string(&reader);
+    row->departs_at = payload_read_int32(&reader);
+    row->platform = payload_read_string(&reader);
+    row->trip_id = payload_read_string(&reader);
+    row->station_id = payload_read_int32(&reader);
+    if (reader.error) {
+      break;
+    }
+  }
+  return parsed;
+}
+
+static char *copy_field(const char **ptr) {
+  const char *p = *ptr;
+  while (*p != '"' && *p != '\0') p++;
+  if (*p == '\0') return NULL;
+  p++;
+  const char *start = p;
+  while (*p != '"' && *p != '\0') p++;
+  if (*p == '\0') return NULL;
+  size_t len = p - start;
+  char *field = malloc(len + 1);
+  strncpy(field, start, len);
+  field[len] = '\0';
+  *ptr = p + 1;
+  return field;
+}
+
+// The old station_window_set_station() scanner: count the rows, then a
+// malloc and strncpy per field
+static int parse_json(const char *data) {
+  int count = 0;
+  for (const char *p = data; *p; p++) {
+    if (*p == '[') count++;
+  }
+  char **fields[4];
+  for (int f = 0; f < 4; f++) {
+    fields[f] = malloc(count * sizeof(char *));
+  }
+  const char *ptr = data;
+  int parsed = 0;
+  while (*ptr != '\0' && parsed < count) {
+    int f = 0;
+    for (; f < 4; f++) {
+      fields[f][parsed] = copy_field(&ptr);
+      if (!fields[f][parsed]) break;
+    }
+    if (f < 4) {
+      for (int i = 0; i < f; i++) free(fields[i][parsed]);
+      break;
+    }
+    parsed++;
+  }
+  for (int f = 0; f < 4; f++) {
+    for (int i = 0; i < parsed; i++) free(fields[f][i]);
+    free(fields[f]);
+  }
+  return parsed;
+}
+
+static void report(const char *name, size_t bytes, int rows, long long iterations, long long elapsed_ns) {
+  double ms = elapsed_ns / 1e6 / iterations;
+  printf("%-8s %6zu bytes %4d rows %9.4f ms/parse %10.0f bytes/ms\n", name, bytes, rows, ms, bytes / ms);
+}
+
+int main() {
+  static char trip_ids[BENCH_ROWS][24];
+  static char platforms[BENCH_ROWS][4];
+  for (int i = 0; i < BENCH_ROWS; i++) {
+    snprintf(trip_ids[i], sizeof(trip_ids[i]), "%d-%d-2510181%03d", 4711 + i, i % 7, i);
+    snprintf(platforms[i], sizeof(platforms[i]), "%d", 1 + i % 11);
+  }
+
+  static uint8_t packed[8192];
+  static uint8_t copy[8192];
+  static char json[16384];
+  static Row rows[BENCH_ROWS];
+  uint16_t packed_length = build_packed(packed, sizeof(packed), trip_ids, platforms);
+  size_t json_length = build_json(json, sizeof(json), platforms);
+  if (!packed_length || json_length >= sizeof(json)) {
+    fprintf(stderr, "bench board does not fit\n");
+    return 1;
+  }
+
+  int parsed = 0;
+  long long iterations = 0;
+  long long start = now_ns();
+  long long elapsed;
+  do {
+    parsed = parse_packed(packed, packed_length, rows, copy);
+    iterations++;
+  } while ((elapsed = now_ns() - start) < BENCH_MIN_NS);
+  report("packed", packed_length, parsed, iterations, elapsed);
+
+  iterations = 0;
+  start = now_ns();
+  do {
+    parsed = parse_json(json);
+    iterations++;
+  } while ((elapsed = now_ns() - start) < BENCH_MIN_NS);
+  report("json", json_length, parsed, iterations, elapsed);
+  return 0;
+}
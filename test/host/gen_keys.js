@@ -0,0 +1,24 @@
+// Writes message_keys.auto.h and resource_ids.auto.h from package.json into
+// the given directory, what the SDK's build generates for the watch
+//
+//   node gen_keys.js ../../package.json build
+var fs = require('fs');
+var path = require('path');
+
+var pebble = JSON.parse(fs.readFileSync(process.argv[2], 'utf8')).pebble;
+var out = process.argv[3];
+
+function header(names, prefix) {
+  // package.json may list a key twice, it is still one key
+  names = names.filter(function(name, index) {
+    return names.indexOf(name) == index;
+  });
+  return '#pragma once\n\n' + names.map(function(name, index) {
+    return '#define ' + prefix + name + ' ' + (index + 1);
+  }).join('\n') + '\n';
+}
+
+fs.writeFileSync(path.join(out, 'message_keys.auto.h'), header(pebble.messageKeys, 'MESSAGE_KEY_'));
+fs.writeFileSync(path.join(out, 'resource_ids.auto.h'), header(pebble.resources.media.map(function(resource) {
+  return resource.name;
+}), 'RESOURCE_ID_'));
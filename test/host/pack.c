@@ -0,0 +1,50 @@
+#include "pack.h"
+
+void pack_init(Packer *packer, uint8_t *buffer, uint16_t capacity) {
+  packer->data = buffer;
+  packer->length = 0;
+  packer->capacity = capacity;
+  packer->overflow = false;
+}
+
+static uint8_t *pack_reserve(Packer *packer, uint16_t size) {
+  if (packer->overflow || packer->capacity - packer->length < size) {
+    packer->overflow = true;
+    return NULL;
+  }
+  uint8_t *ptr = packer->data + packer->length;
+  packer->length += size;
+  return ptr;
+}
+
+void pack_uint8(Packer *packer, uint8_t value) {
+  uint8_t *ptr = pack_reserve(packer, 1);
+  if (ptr) {
+    *ptr = value;
+  }
+}
+
+void pack_int32(Packer *packer, int32_t value) {
+  uint8_t *ptr = pack_reserve(packer, 4);
+  if (ptr) {
+    uint32_t v = (uint32_t)value;
+    ptr[0] = v & 0xFF;
+    ptr[1] = (v >> 8) & 0xFF;
+    ptr[2] = (v >> 16) & 0xFF;
+    ptr[3] = (v >> 24) & 0xFF;
+  }
+}
+
+// [length][UTF-8 bytes][0], the length byte leaves out the terminator
+void pack_string(Packer *packer, const char *str) {
+  size_t len = strlen(str);
+  if (len > 255) {
+    packer->overflow = true;
+    return;
+  }
+  pack_uint8(packer, len);
+  uint8_t *ptr = pack_reserve(packer, len + 1);
+  if (ptr) {
+    memcpy(ptr, str, len + 1);
+  }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <pebble.h>
+
+// Writes payloads the way the phone packs them (see packRows() in
+// src/pkjs/index.js), for tests and benchmarks to read back
+typedef struct {
+  uint8_t *data;
+  uint16_t length;
+  uint16_t capacity;
+  bool overflow;
+} Packer;
+
+void pack_init(Packer *packer, uint8_t *buffer, uint16_t capacity);
+void pack_uint8(Packer *packer, uint8_t value);
+void pack_int32(Packer *packer, int32_t value);
+void pack_string(Packer *packer, const char *str);
@@ -0,0 +1,43 @@
+// Packs a recorded /pebble/current answer the way the phone sends a board
+// (see boardRows() and packChunks() in src/pkjs/index.js), all rows in one
+// payload. The benchmark chunks it with the watch's own payload_fit_rows().
+//
+//   node pack_fixture.js ../fixtures/current/8000207.json build/fixtures/8000207.bin
+var fs = require('fs');
+var path = require('path');
+
+var input = process.argv[2];
+var output = process.argv[3];
+var stationId = parseInt(path.basename(input), 10) || 0;
+var departures = JSON.parse(fs.readFileSync(input, 'utf8'));
+
+function appendString(bytes, str) {
+  var utf8 = Buffer.from(str == null ? '' : str.toString(), 'utf8');
+  var len = Math.min(utf8.length, 254);
+  while (len < utf8.length && (utf8[len] & 0xC0) == 0x80) {
+    len--;
+  }
+  bytes.push(len);
+  for (var i = 0; i < len; i++) {
+    bytes.push(utf8[i]);
+  }
+  bytes.push(0);
+}
+
+function appendInt32(bytes, value) {
+  bytes.push(value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, (value >> 24) & 0xFF);
+}
+
+var rows = departures.slice(0, 255);
+var bytes = [rows.length];
+rows.forEach(function(departure) {
+  appendString(bytes, departure[2]);
+  appendString(bytes, departure[3]);
+  appendInt32(bytes, Math.floor(Date.parse(departure[4]) / 1000));
+  appendString(bytes, departure[5]);
+  appendString(bytes, departure[0]);
+  appendInt32(bytes, stationId);
+});
+
+fs.mkdirSync(path.dirname(output), { recursive: true });
+fs.writeFileSync(output, Buffer.from(bytes));
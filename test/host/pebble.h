@@ -0,0 +1,236 @@
+#pragma once
+
+// Just enough of the Pebble SDK for the modules that don't draw anything,
+// so they can be built and tested on the host, and for station_window.c
+// with its drawing stubbed out (pebble_ui_stub.c). See Makefile.
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef enum {
+  TUPLE_BYTE_ARRAY = 0,
+  TUPLE_CSTRING = 1,
+  TUPLE_UINT = 2,
+  TUPLE_INT = 3,
+} TupleType;
+
+// Same layout as the SDK: the value follows the header in the inbox buffer
+typedef struct __attribute__((__packed__)) {
+  uint32_t key;
+  TupleType type:8;
+  uint16_t length;
+  union {
+    uint8_t data[0];
+    char cstring[0];
+    uint8_t uint8;
+    int32_t int32;
+  } value[];
+} Tuple;
+
+typedef enum {
+  APP_MSG_OK = 0,
+  APP_MSG_SEND_TIMEOUT = 1 << 1,
+  APP_MSG_SEND_REJECTED = 1 << 2,
+  APP_MSG_NOT_CONNECTED = 1 << 3,
+  APP_MSG_BUSY = 1 << 6,
+  APP_MSG_BUFFER_OVERFLOW = 1 << 7,
+  APP_MSG_OUT_OF_MEMORY = 1 << 11,
+} AppMessageResult;
+
+typedef enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200,
+  APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+} AppLogLevel;
+
+// Printed only with HOST_LOG=1 in the environment
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+#define APP_LOG(level, fmt, ...) app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+// The app heap of the platform profile the host build runs as. Every
+// allocation goes through the host_ functions and is counted, and fails
+// like it would on the watch once the profile's heap is used up.
+size_t heap_bytes_used(void);
+size_t heap_bytes_free(void);
+
+void *host_malloc(size_t size);
+void *host_calloc(size_t count, size_t size);
+void *host_realloc(void *ptr, size_t size);
+void host_free(void *ptr);
+#define malloc host_malloc
+#define calloc host_calloc
+#define realloc host_realloc
+#define free host_free
+
+typedef struct {
+  size_t heap_size;
+  size_t used;
+  size_t peak;
+  unsigned allocations;
+  unsigned failed;
+} HostHeapStats;
+
+// Starts counting again with a heap of heap_size bytes, live blocks stay counted
+void host_heap_reset(size_t heap_size);
+HostHeapStats host_heap_stats(void);
+
+// Generated from package.json by gen_keys.js, like the SDK's build does
+#include "message_keys.auto.h"
+#include "resource_ids.auto.h"
+
+// A rect display like basalt's. The board code only asks for the shape,
+// the heap of each platform comes from the profile the bench runs as.
+#define PBL_RECT 1
+#define PBL_COLOR 1
+#define PBL_DISPLAY_WIDTH 144
+#define PBL_DISPLAY_HEIGHT 168
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_false)
+
+#define STATUS_BAR_LAYER_HEIGHT 16
+#define MENU_CELL_BASIC_HEADER_HEIGHT 16
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_14_BOLD "RESOURCE_ID_GOTHIC_14_BOLD"
+#define FONT_KEY_GOTHIC_18 "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24_BOLD "RESOURCE_ID_GOTHIC_24_BOLD"
+
+typedef struct {
+  int16_t x;
+  int16_t y;
+} GPoint;
+
+typedef struct {
+  int16_t w;
+  int16_t h;
+} GSize;
+
+typedef struct {
+  GPoint origin;
+  GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint){ (x), (y) })
+#define GRect(x, y, w, h) ((GRect){ { (x), (y) }, { (w), (h) } })
+
+typedef uint8_t GColor;
+#define GColorBlack ((GColor)0xC0)
+#define GColorWhite ((GColor)0xFF)
+#define GColorDarkGreen ((GColor)0xC4)
+#define GColorIslamicGreen ((GColor)0xC8)
+#define GColorClear ((GColor)0x00)
+
+typedef enum {
+  GTextOverflowModeWordWrap,
+  GTextOverflowModeTrailingEllipsis,
+  GTextOverflowModeFill,
+} GTextOverflowMode;
+
+typedef enum {
+  GTextAlignmentLeft,
+  GTextAlignmentCenter,
+  GTextAlignmentRight,
+} GTextAlignment;
+
+typedef enum {
+  GCornerNone = 0,
+  GCornersAll = 15,
+} GCornerMask;
+
+typedef enum {
+  SECOND_UNIT = 1 << 0,
+  MINUTE_UNIT = 1 << 1,
+  HOUR_UNIT = 1 << 2,
+} TimeUnits;
+
+typedef struct GContext GContext;
+typedef struct GTextAttributes GTextAttributes;
+typedef struct GDrawCommandImage GDrawCommandImage;
+typedef struct FontInfo *GFont;
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef struct MenuLayer MenuLayer;
+typedef struct StatusBarLayer StatusBarLayer;
+typedef struct AppTimer AppTimer;
+
+typedef void (*WindowHandler)(Window *window);
+typedef struct {
+  WindowHandler load;
+  WindowHandler appear;
+  WindowHandler disappear;
+  WindowHandler unload;
+} WindowHandlers;
+
+typedef struct {
+  uint16_t section;
+  uint16_t row;
+} MenuIndex;
+
+typedef struct {
+  uint16_t (*get_num_sections)(MenuLayer *menu_layer, void *context);
+  uint16_t (*get_num_rows)(MenuLayer *menu_layer, uint16_t section_index, void *context);
+  int16_t (*get_cell_height)(MenuLayer *menu_layer, MenuIndex *cell_index, void *context);
+  int16_t (*get_header_height)(MenuLayer *menu_layer, uint16_t section_index, void *context);
+  void (*draw_row)(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index, void *context);
+  void (*draw_header)(GContext *ctx, const Layer *cell_layer, uint16_t section_index, void *context);
+  void (*select_click)(MenuLayer *menu_layer, MenuIndex *cell_index, void *context);
+  void (*select_long_click)(MenuLayer *menu_layer, MenuIndex *cell_index, void *context);
+} MenuLayerCallbacks;
+
+typedef void (*AppTimerCallback)(void *data);
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+
+Window *window_create(void);
+void window_destroy(Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_user_data(Window *window, void *data);
+void *window_get_user_data(const Window *window);
+Layer *window_get_root_layer(const Window *window);
+bool window_is_loaded(Window *window);
+void window_stack_push(Window *window, bool animated);
+Window *window_stack_pop(bool animated);
+bool window_stack_remove(Window *window, bool animated);
+bool window_stack_contains_window(Window *window);
+Window *window_stack_get_top_window(void);
+
+GRect layer_get_bounds(const Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_mark_dirty(Layer *layer);
+
+MenuLayer *menu_layer_create(GRect frame);
+void menu_layer_destroy(MenuLayer *menu_layer);
+Layer *menu_layer_get_layer(const MenuLayer *menu_layer);
+void menu_layer_set_callbacks(MenuLayer *menu_layer, void *callback_context, MenuLayerCallbacks callbacks);
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer, Window *window);
+void menu_layer_set_highlight_colors(MenuLayer *menu_layer, GColor background, GColor foreground);
+void menu_layer_reload_data(MenuLayer *menu_layer);
+bool menu_cell_layer_is_highlighted(const Layer *cell_layer);
+void menu_cell_basic_header_draw(GContext *ctx, const Layer *cell_layer, const char *title);
+
+StatusBarLayer *status_bar_layer_create(void);
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer);
+Layer *status_bar_layer_get_layer(StatusBarLayer *status_bar_layer);
+void status_bar_layer_set_colors(StatusBarLayer *status_bar_layer, GColor background, GColor foreground);
+
+GFont fonts_get_system_font(const char *font_key);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box, GTextOverflowMode overflow_mode,
+                        GTextAlignment alignment, GTextAttributes *text_attributes);
+void gdraw_command_image_draw(GContext *ctx, GDrawCommandImage *image, GPoint offset);
+
+// Timers and ticks never fire, the bench calls what they would
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+void app_timer_cancel(AppTimer *timer);
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
@@ -0,0 +1,105 @@
+#include <pebble.h>
+#include <stdarg.h>
+
+// The real allocator, below the counting one
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+// Basalt, chalk and diorite, see the profiles in bench_board.c
+#define HOST_DEFAULT_HEAP_SIZE 65536
+
+// Every block starts with its size, so free() knows what to give back.
+// The union keeps the block after it aligned like malloc's.
+typedef union {
+  size_t size;
+  max_align_t align;
+} BlockHeader;
+
+static HostHeapStats s_heap = { .heap_size = HOST_DEFAULT_HEAP_SIZE };
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+  static int s_enabled = -1;
+  if (s_enabled < 0) {
+    const char *env = getenv("HOST_LOG");
+    s_enabled = env && env[0] == '1';
+  }
+  if (!s_enabled) {
+    return;
+  }
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "[%d] %s:%d ", log_level, src_filename, src_line_number);
+  vfprintf(stderr, fmt, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+size_t heap_bytes_used(void) {
+  return s_heap.used;
+}
+
+size_t heap_bytes_free(void) {
+  return s_heap.used < s_heap.heap_size ? s_heap.heap_size - s_heap.used : 0;
+}
+
+void host_heap_reset(size_t heap_size) {
+  s_heap.heap_size = heap_size;
+  s_heap.peak = s_heap.used;
+  s_heap.allocations = 0;
+  s_heap.failed = 0;
+}
+
+HostHeapStats host_heap_stats(void) {
+  return s_heap;
+}
+
+void *host_malloc(size_t size) {
+  if (size > heap_bytes_free()) {
+    s_heap.failed++;
+    return NULL;
+  }
+  BlockHeader *header = malloc(sizeof(BlockHeader) + size);
+  if (!header) {
+    s_heap.failed++;
+    return NULL;
+  }
+  header->size = size;
+  s_heap.used += size;
+  if (s_heap.used > s_heap.peak) {
+    s_heap.peak = s_heap.used;
+  }
+  s_heap.allocations++;
+  return header + 1;
+}
+
+void *host_calloc(size_t count, size_t size) {
+  void *ptr = host_malloc(count * size);
+  if (ptr) {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+void *host_realloc(void *ptr, size_t size) {
+  if (!ptr) {
+    return host_malloc(size);
+  }
+  size_t old_size = ((BlockHeader *)ptr - 1)->size;
+  void *copy = host_malloc(size);
+  if (copy) {
+    memcpy(copy, ptr, old_size < size ? old_size : size);
+    host_free(ptr);
+  }
+  return copy;
+}
+
+void host_free(void *ptr) {
+  if (!ptr) {
+    return;
+  }
+  BlockHeader *header = (BlockHeader *)ptr - 1;
+  s_heap.used -= header->size;
+  free(header);
+}
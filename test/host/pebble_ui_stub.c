@@ -0,0 +1,225 @@
+#include <pebble.h>
+
+// The UI calls of station_window.c. Windows keep their user data and run
+// their handlers when pushed and removed, everything else does nothing.
+// Windows and layers come from the counted heap, like on the watch.
+#define WINDOW_STACK_SIZE 16
+
+struct Layer {
+  GRect bounds;
+};
+
+struct Window {
+  Layer root_layer;
+  WindowHandlers handlers;
+  void *user_data;
+  bool loaded;
+};
+
+struct MenuLayer {
+  Layer layer;
+};
+
+struct StatusBarLayer {
+  Layer layer;
+};
+
+// Oldest first
+static Window *s_stack[WINDOW_STACK_SIZE];
+static int s_stack_count = 0;
+// What app_timer_register() hands out, the timers are never run
+static char s_timer;
+
+Window *window_create(void) {
+  Window *window = calloc(1, sizeof(Window));
+  if (window) {
+    window->root_layer.bounds = GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT);
+  }
+  return window;
+}
+
+void window_destroy(Window *window) {
+  free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_set_user_data(Window *window, void *data) {
+  window->user_data = data;
+}
+
+void *window_get_user_data(const Window *window) {
+  return window->user_data;
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return (Layer *)&window->root_layer;
+}
+
+bool window_is_loaded(Window *window) {
+  return window->loaded;
+}
+
+void window_stack_push(Window *window, bool animated) {
+  if (s_stack_count == WINDOW_STACK_SIZE || window_stack_contains_window(window)) {
+    return;
+  }
+  Window *top = window_stack_get_top_window();
+  if (top && top->handlers.disappear) {
+    top->handlers.disappear(top);
+  }
+  s_stack[s_stack_count++] = window;
+  if (!window->loaded) {
+    window->loaded = true;
+    if (window->handlers.load) {
+      window->handlers.load(window);
+    }
+  }
+  if (window->handlers.appear) {
+    window->handlers.appear(window);
+  }
+}
+
+Window *window_stack_pop(bool animated) {
+  Window *top = window_stack_get_top_window();
+  if (top) {
+    window_stack_remove(top, animated);
+  }
+  return top;
+}
+
+bool window_stack_remove(Window *window, bool animated) {
+  for (int i = 0; i < s_stack_count; i++) {
+    if (s_stack[i] != window) {
+      continue;
+    }
+    bool was_top = i == s_stack_count - 1;
+    memmove(&s_stack[i], &s_stack[i + 1], (s_stack_count - i - 1) * sizeof(Window *));
+    s_stack_count--;
+    if (was_top && window->handlers.disappear) {
+      window->handlers.disappear(window);
+    }
+    window->loaded = false;
+    if (window->handlers.unload) {
+      window->handlers.unload(window);
+    }
+    Window *top = window_stack_get_top_window();
+    if (was_top && top && top->handlers.appear) {
+      top->handlers.appear(top);
+    }
+    return true;
+  }
+  return false;
+}
+
+bool window_stack_contains_window(Window *window) {
+  for (int i = 0; i < s_stack_count; i++) {
+    if (s_stack[i] == window) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Window *window_stack_get_top_window(void) {
+  return s_stack_count > 0 ? s_stack[s_stack_count - 1] : NULL;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return layer->bounds;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+}
+
+void layer_mark_dirty(Layer *layer) {
+}
+
+MenuLayer *menu_layer_create(GRect frame) {
+  MenuLayer *menu_layer = calloc(1, sizeof(MenuLayer));
+  if (menu_layer) {
+    menu_layer->layer.bounds = GRect(0, 0, frame.size.w, frame.size.h);
+  }
+  return menu_layer;
+}
+
+void menu_layer_destroy(MenuLayer *menu_layer) {
+  free(menu_layer);
+}
+
+Layer *menu_layer_get_layer(const MenuLayer *menu_layer) {
+  return (Layer *)&menu_layer->layer;
+}
+
+void menu_layer_set_callbacks(MenuLayer *menu_layer, void *callback_context, MenuLayerCallbacks callbacks) {
+}
+
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer, Window *window) {
+}
+
+void menu_layer_set_highlight_colors(MenuLayer *menu_layer, GColor background, GColor foreground) {
+}
+
+void menu_layer_reload_data(MenuLayer *menu_layer) {
+}
+
+bool menu_cell_layer_is_highlighted(const Layer *cell_layer) {
+  return false;
+}
+
+void menu_cell_basic_header_draw(GContext *ctx, const Layer *cell_layer, const char *title) {
+}
+
+StatusBarLayer *status_bar_layer_create(void) {
+  StatusBarLayer *status_bar_layer = calloc(1, sizeof(StatusBarLayer));
+  if (status_bar_layer) {
+    status_bar_layer->layer.bounds = GRect(0, 0, PBL_DISPLAY_WIDTH, STATUS_BAR_LAYER_HEIGHT);
+  }
+  return status_bar_layer;
+}
+
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer) {
+  free(status_bar_layer);
+}
+
+Layer *status_bar_layer_get_layer(StatusBarLayer *status_bar_layer) {
+  return &status_bar_layer->layer;
+}
+
+void status_bar_layer_set_colors(StatusBarLayer *status_bar_layer, GColor background, GColor foreground) {
+}
+
+GFont fonts_get_system_font(const char *font_key) {
+  return NULL;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box, GTextOverflowMode overflow_mode,
+                        GTextAlignment alignment, GTextAttributes *text_attributes) {
+}
+
+void gdraw_command_image_draw(GContext *ctx, GDrawCommandImage *image, GPoint offset) {
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  return (AppTimer *)&s_timer;
+}
+
+void app_timer_cancel(AppTimer *timer) {
+}
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+}
+
+void tick_timer_service_unsubscribe(void) {
+}
@@ -0,0 +1,58 @@
+#include "../../src/c/modules/icon_cache.h"
+#include "../../src/c/modules/launch_cache.h"
+#include "../../src/c/modules/nav_stack.h"
+#include "../../src/c/modules/request_queue.h"
+#include "../../src/c/modules/trace.h"
+#include "../../src/c/windows/loading_window.h"
+
+// What station_window.c calls besides the rows: requests, the trace, the
+// window stack, the icons and the other windows. None of it is measured by
+// the bench.
+
+void trace_event(TraceEvent event, int32_t value) {
+}
+
+void trace_send() {
+}
+
+bool request_queue_send_text(uint32_t key, int32_t value, uint32_t text_key, const char *text) {
+  return true;
+}
+
+void request_queue_send_background(uint32_t key, int32_t value) {
+}
+
+bool request_queue_is_current(int32_t request_id) {
+  return true;
+}
+
+void nav_stack_push(Window *window) {
+  window_stack_push(window, true);
+}
+
+void nav_stack_make_room() {
+}
+
+void nav_stack_remove(Window *window) {
+}
+
+GDrawCommandImage *icon_cache_get_scaled(uint32_t resource_id, int16_t size) {
+  return NULL;
+}
+
+void icon_cache_release(GDrawCommandImage *image) {
+}
+
+void launch_cache_format_stale(char *buffer, size_t size, time_t fetched_at) {
+  snprintf(buffer, size, "Stand von vorhin");
+}
+
+void loading_window_push() {
+}
+
+void loading_window_remove() {
+}
+
+Window *loading_window_get_covered() {
+  return window_stack_get_top_window();
+}
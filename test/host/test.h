@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+// Keeps going after a failed check so one run lists every failure
+static int s_checks = 0;
+static int s_failures = 0;
+
+#define CHECK(cond) do { \
+    s_checks++; \
+    if (!(cond)) { \
+      s_failures++; \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+  } while (0)
+
+static inline bool str_equals(const char *actual, const char *expected) {
+  return actual && strcmp(actual, expected) == 0;
+}
+
+#define CHECK_STR(actual, expected) CHECK(str_equals((actual), (expected)))
+
+#define TEST_RESULT(name) ( \
+    printf("%s: %d checks, %d failed\n", (name), s_checks, s_failures), \
+    s_failures ? 1 : 0)
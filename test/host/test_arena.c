@@ -0,0 +1,97 @@
+#include "test.h"
+#include "arena.h"
+
+static void test_alloc_is_aligned_and_counted() {
+  size_t before = heap_bytes_used();
+  Arena *arena = arena_create(64);
+  CHECK(arena != NULL);
+  char *a = arena_alloc(arena, 1);
+  char *b = arena_alloc(arena, 5);
+  CHECK(a && b);
+  CHECK(((uintptr_t)a & 3) == 0);
+  CHECK(((uintptr_t)b & 3) == 0);
+  CHECK(b - a == 4);
+  CHECK(arena_used(arena) == 12);
+  arena_destroy(arena);
+  CHECK(heap_bytes_used() == before);
+}
+
+static void test_overflow_blocks_are_chained_and_reset() {
+  size_t before = heap_bytes_used();
+  Arena *arena = arena_create(16);
+  size_t first_block = heap_bytes_used() - before;
+  CHECK(arena_alloc(arena, 16) != NULL);
+  // Does not fit any more, a block of at least 512 bytes is added
+  char *overflow = arena_alloc(arena, 8);
+  CHECK(overflow != NULL);
+  CHECK(heap_bytes_used() - before >= first_block + 512);
+  CHECK(arena_used(arena) == 24);
+  // Bigger than the overflow size gets a block of its own size
+  CHECK(arena_alloc(arena, 2000) != NULL);
+  CHECK(arena_used(arena) == 2024);
+
+  arena_reset(arena);
+  CHECK(arena_used(arena) == 0);
+  CHECK(heap_bytes_used() - before == first_block);
+  arena_destroy(arena);
+  CHECK(heap_bytes_used() == before);
+}
+
+static void test_strdup() {
+  Arena *arena = arena_create(32);
+  char *copy = arena_strdup(arena, "Köln Hbf");
+  CHECK_STR(copy, "Köln Hbf");
+  CHECK(arena_used(arena) == 12);
+  arena_destroy(arena);
+}
+
+static void test_reuse_or_create() {
+  Arena *arena = arena_create(100);
+  arena_alloc(arena, 60);
+  // Big enough: the same arena, emptied
+  Arena *reused = arena_reuse_or_create(arena, 100);
+  CHECK(reused == arena);
+  CHECK(arena_used(reused) == 0);
+  // Too small: replaced
+  size_t before = heap_bytes_used();
+  Arena *bigger = arena_reuse_or_create(reused, 400);
+  CHECK(bigger != NULL);
+  CHECK(heap_bytes_used() == before + 300);
+  CHECK(arena_alloc(bigger, 400) != NULL);
+  arena_destroy(bigger);
+
+  Arena *fresh = arena_reuse_or_create(NULL, 10);
+  CHECK(fresh != NULL);
+  arena_destroy(fresh);
+}
+
+static void test_out_of_heap() {
+  CHECK(arena_alloc(NULL, 4) == NULL);
+  arena_destroy(NULL);
+  arena_reset(NULL);
+
+  HostHeapStats stats = host_heap_stats();
+  // An aplite sized heap that is almost used up
+  host_heap_reset(stats.used + 1024);
+  CHECK(arena_create(4096) == NULL);
+  Arena *arena = arena_create(256);
+  CHECK(arena != NULL);
+  CHECK(arena_alloc(arena, 256) != NULL);
+  // The first overflow block would be 512 bytes, still fits
+  CHECK(arena_alloc(arena, 4) != NULL);
+  // The next one doesn't
+  CHECK(arena_alloc(arena, 600) == NULL);
+  CHECK(host_heap_stats().failed == 2);
+  arena_log_heap("test");
+  arena_destroy(arena);
+  host_heap_reset(stats.heap_size);
+}
+
+int main() {
+  test_alloc_is_aligned_and_counted();
+  test_overflow_blocks_are_chained_and_reset();
+  test_strdup();
+  test_reuse_or_create();
+  test_out_of_heap();
+  return TEST_RESULT("arena");
+}
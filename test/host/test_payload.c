@@ -0,0 +1,219 @@
+#include "test.h"
+#include "pack.h"
+#include "payload.h"
+
+// Builds a Tuple around a payload the way it sits in the inbox
+static Tuple *make_tuple(const uint8_t *data, uint16_t length, TupleType type) {
+  Tuple *tuple = malloc(sizeof(Tuple) + length);
+  tuple->key = 1;
+  tuple->type = type;
+  tuple->length = length;
+  memcpy(tuple->value->data, data, length);
+  return tuple;
+}
+
+static void test_reads_a_board_row() {
+  uint8_t buffer[128];
+  Packer packer;
+  pack_init(&packer, buffer, sizeof(buffer));
+  pack_uint8(&packer, 1);
+  pack_string(&packer, "STR 18");
+  pack_string(&packer, "Bonn Hbf");
+  pack_int32(&packer, 1760000000);
+  pack_string(&packer, "2");
+  pack_string(&packer, "trip-1");
+  pack_int32(&packer, -1);
+
+  Tuple *tuple = make_tuple(buffer, packer.length, TUPLE_BYTE_ARRAY);
+  PayloadReader reader;
+  CHECK(payload_reader_init_tuple(&reader, tuple));
+  CHECK(payload_read_uint8(&reader) == 1);
+  CHECK_STR(payload_read_string(&reader), "STR 18");
+  CHECK_STR(payload_read_string(&reader), "Bonn Hbf");
+  CHECK(payload_read_int32(&reader) == 1760000000);
+  CHECK_STR(payload_read_string(&reader), "2");
+  CHECK_STR(payload_read_string(&reader), "trip-1");
+  CHECK(payload_read_int32(&reader) == -1);
+  CHECK(!reader.error);
+  CHECK(payload_reader_remaining(&reader) == 0);
+  free(tuple);
+}
+
+static void test_empty_strings_and_umlauts() {
+  uint8_t buffer[64];
+  Packer packer;
+  pack_init(&packer, buffer, sizeof(buffer));
+  pack_string(&packer, "");
+  pack_string(&packer, "Köln-Mülheim Wiener Platz");
+
+  PayloadReader reader;
+  payload_reader_init(&reader, buffer, packer.length);
+  CHECK_STR(payload_read_string(&reader), "");
+  CHECK_STR(payload_read_string(&reader), "Köln-Mülheim Wiener Platz");
+  CHECK(!reader.error);
+}
+
+static void test_rejects_missing_or_wrong_tuples() {
+  PayloadReader reader;
+  CHECK(!payload_reader_init_tuple(&reader, NULL));
+  CHECK(reader.error);
+  CHECK(payload_read_uint8(&reader) == 0);
+  CHECK(payload_read_string(&reader) == NULL);
+
+  Tuple *text = make_tuple((const uint8_t *)"[]", 3, TUPLE_CSTRING);
+  CHECK(!payload_reader_init_tuple(&reader, text));
+  free(text);
+
+  Tuple *empty = make_tuple(NULL, 0, TUPLE_BYTE_ARRAY);
+  CHECK(!payload_reader_init_tuple(&reader, empty));
+  free(empty);
+}
+
+static void test_never_reads_past_the_end() {
+  uint8_t buffer[32];
+  Packer packer;
+  pack_init(&packer, buffer, sizeof(buffer));
+  pack_string(&packer, "Bonn");
+
+  // Cut off inside the string
+  PayloadReader reader;
+  payload_reader_init(&reader, buffer, 3);
+  CHECK(payload_read_string(&reader) == NULL);
+  CHECK(reader.error);
+  CHECK(payload_reader_remaining(&reader) == 0);
+
+  // Cut off right before the terminator
+  payload_reader_init(&reader, buffer, packer.length - 1);
+  CHECK(payload_read_string(&reader) == NULL);
+
+  // A length byte that points past the end
+  uint8_t bad_length[] = { 200, 'a', 'b', 0 };
+  payload_reader_init(&reader, bad_length, sizeof(bad_length));
+  CHECK(payload_read_string(&reader) == NULL);
+
+  // No terminator where the length says it is
+  uint8_t no_terminator[] = { 2, 'a', 'b', 'c' };
+  payload_reader_init(&reader, no_terminator, sizeof(no_terminator));
+  CHECK(payload_read_string(&reader) == NULL);
+
+  uint8_t short_int[] = { 1, 2, 3 };
+  payload_reader_init(&reader, short_int, sizeof(short_int));
+  CHECK(payload_read_int32(&reader) == 0);
+  CHECK(reader.error);
+
+  // Once failed, it stays failed
+  payload_reader_init(&reader, buffer, packer.length);
+  payload_read_int32(&reader);
+  payload_read_int32(&reader);
+  CHECK(reader.error);
+  CHECK(payload_read_uint8(&reader) == 0);
+}
+
+static void test_copy_to_keeps_reading() {
+  uint8_t buffer[32];
+  Packer packer;
+  pack_init(&packer, buffer, sizeof(buffer));
+  pack_uint8(&packer, 1);
+  pack_string(&packer, "RE 5");
+
+  PayloadReader reader;
+  payload_reader_init(&reader, buffer, packer.length);
+  payload_read_uint8(&reader);
+  uint8_t copy[32];
+  payload_reader_copy_to(&reader, copy);
+  memset(buffer, 0, sizeof(buffer));
+  char *line = payload_read_string(&reader);
+  CHECK_STR(line, "RE 5");
+  CHECK(line == (char *)copy + 1);
+
+  payload_reader_copy_to(&reader, NULL);
+  CHECK(reader.error);
+}
+
+static void test_copy_string_keeps_characters_whole() {
+  char dest[6];
+  payload_copy_string(dest, sizeof(dest), "Bonn");
+  CHECK_STR(dest, "Bonn");
+  payload_copy_string(dest, sizeof(dest), "Bonn Hbf");
+  CHECK_STR(dest, "Bonn ");
+  // "Köln" is 5 bytes
+  payload_copy_string(dest, sizeof(dest), "Köln-Mülheim");
+  CHECK_STR(dest, "Köln");
+  char small[4];
+  payload_copy_string(small, sizeof(small), "Köln");
+  CHECK_STR(small, "K\xc3\xb6");
+  // The 2nd byte would be the first half of "ö"
+  char two[3];
+  payload_copy_string(two, sizeof(two), "Köln");
+  CHECK_STR(two, "K");
+}
+
+// Two rows of STATION_ROW_FORMAT, returns the length of the first
+static uint16_t pack_two_rows(Packer *packer, uint8_t count) {
+  pack_uint8(packer, count);
+  pack_string(packer, "S 12");
+  pack_string(packer, "Düren");
+  pack_int32(packer, 1760000000);
+  pack_string(packer, "9");
+  pack_string(packer, "trip-1");
+  pack_int32(packer, 8000207);
+  uint16_t first_row_end = packer->length;
+  pack_string(packer, "RE 5");
+  pack_string(packer, "Koblenz Hbf");
+  pack_int32(packer, 1760000300);
+  pack_string(packer, "");
+  pack_string(packer, "trip-2");
+  pack_int32(packer, 8000207);
+  return first_row_end;
+}
+
+static void test_fit_rows() {
+  uint8_t buffer[128];
+  Packer packer;
+  pack_init(&packer, buffer, sizeof(buffer));
+  uint16_t first_row_end = pack_two_rows(&packer, 2);
+  uint8_t rows;
+
+  CHECK(payload_fit_rows(buffer, packer.length, "ssissi", 4096, &rows) == packer.length);
+  CHECK(rows == 2);
+  CHECK(payload_fit_rows(buffer, packer.length, "ssissi", packer.length, &rows) == packer.length);
+  CHECK(rows == 2);
+  // One byte short of the second row
+  CHECK(payload_fit_rows(buffer, packer.length, "ssissi", packer.length - 1, &rows) == first_row_end);
+  CHECK(rows == 1);
+  // Not even the first one, only the count byte
+  CHECK(payload_fit_rows(buffer, packer.length, "ssissi", first_row_end - 1, &rows) == 1);
+  CHECK(rows == 0);
+}
+
+static void test_fit_rows_stops_at_broken_rows() {
+  uint8_t buffer[128];
+  Packer packer;
+  pack_init(&packer, buffer, sizeof(buffer));
+  // Says 3 rows, has 2
+  pack_two_rows(&packer, 3);
+  uint8_t rows;
+  CHECK(payload_fit_rows(buffer, packer.length, "ssissi", 4096, &rows) == packer.length);
+  CHECK(rows == 2);
+  // Cut off in the middle of the second row
+  uint16_t first_row_end = payload_fit_rows(buffer, packer.length, "ssissi", packer.length - 1, &rows);
+  CHECK(payload_fit_rows(buffer, packer.length - 3, "ssissi", 4096, &rows) == first_row_end);
+  CHECK(rows == 1);
+  // Read with the wrong format
+  payload_fit_rows(buffer, packer.length, "iiiiiiiiiiiiiiiiiiiiiiiiii", 4096, &rows);
+  CHECK(rows == 0);
+  CHECK(payload_fit_rows(NULL, 0, "ssissi", 4096, &rows) == 1);
+  CHECK(rows == 0);
+}
+
+int main() {
+  test_reads_a_board_row();
+  test_empty_strings_and_umlauts();
+  test_rejects_missing_or_wrong_tuples();
+  test_never_reads_past_the_end();
+  test_copy_to_keeps_reading();
+  test_copy_string_keeps_characters_whole();
+  test_fit_rows();
+  test_fit_rows_stops_at_broken_rows();
+  return TEST_RESULT("payload");
+}
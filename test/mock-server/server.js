@@ -0,0 +1,228 @@
+// Stand-in for bahnhof-server that answers from the recorded fixtures in
+// ../fixtures, so the app can be run and measured without the live API.
+// Point API_URL in the app settings at it, e.g. http://<your ip>:8080
+//
+//   node server.js [--port=8080] [--latency=300] [--jitter=200] [--scale=4]
+//                  [--not-found=0.2] [--timeout=0.1] [--only=moreinfo] [--strict]
+//
+// latency   ms added to every answer, jitter adds up to that many ms more
+// scale     repeats every board that many times, for hubs bigger than Köln Hbf
+// not-found share of requests answered with 404 (0..1)
+// timeout   share of requests that never get an answer (0..1)
+// only      the two above only hit paths containing this, e.g. "moreinfo"
+// strict    unknown stations are a 404, by default they get the smallest board
+// no-rebase keeps the recorded times, by default boards start a minute from now
+//
+// Endpoints: /pebble/stations, /pebble/currentLocation, /pebble/current/{id}
+// and /pebble/moreinfo/{station}/{uuid}. The fields parameter and
+// If-None-Match work like on the real server.
+var crypto = require('crypto');
+var fs = require('fs');
+var http = require('http');
+var path = require('path');
+var url = require('url');
+
+var fixtures = path.join(__dirname, '..', 'fixtures');
+
+var options = {
+  port: 8080,
+  latency: 0,
+  jitter: 0,
+  scale: 1,
+  "not-found": 0,
+  timeout: 0,
+  only: '',
+  strict: false,
+  "no-rebase": false
+};
+
+process.argv.slice(2).forEach(function(arg) {
+  var match = /^--([^=]+)(?:=(.*))?$/.exec(arg);
+  if (!match || !(match[1] in options)) {
+    console.error('unknown option ' + arg);
+    process.exit(1);
+  }
+  var value = match[2];
+  if (typeof options[match[1]] == 'boolean') {
+    options[match[1]] = value === undefined || value == '1' || value == 'true';
+  } else if (typeof options[match[1]] == 'number') {
+    options[match[1]] = parseFloat(value);
+  } else {
+    options[match[1]] = value || '';
+  }
+});
+
+function readFixture(name) {
+  return JSON.parse(fs.readFileSync(path.join(fixtures, name), 'utf8'));
+}
+
+var stations = readFixture('stations.json');
+var stops = readFixture('stops.json');
+var boards = {};
+fs.readdirSync(path.join(fixtures, 'current')).forEach(function(file) {
+  if (/\.json$/.test(file)) {
+    boards[parseInt(file, 10)] = readFixture(path.join('current', file));
+  }
+});
+var smallestBoard = Object.keys(boards).sort(function(a, b) {
+  return boards[a].length - boards[b].length;
+})[0];
+
+// Recorded times are moved so the first departure is a minute from now,
+// the watch counts down to them and drops trains that have left
+function rebase(board) {
+  if (options["no-rebase"] || board.length == 0) {
+    return board;
+  }
+  // whole minutes, so the ETag stays the same within a minute
+  var now = Math.floor(Date.now() / 60000) * 60000;
+  var shift = now + 60 * 1000 - Date.parse(board[0][4]);
+  return board.map(function(row) {
+    var moved = row.slice();
+    moved[1] = new Date(Date.parse(row[1]) + shift).toISOString();
+    moved[4] = new Date(Date.parse(row[4]) + shift).toISOString();
+    return moved;
+  });
+}
+
+// Huge hubs: the board again with other trip ids, a bit later each time
+function scaled(board) {
+  var rows = board.slice();
+  for (var copy = 1; copy < options.scale; copy++) {
+    board.forEach(function(row) {
+      var extra = row.slice();
+      extra[0] = row[0] + '-' + copy;
+      extra[1] = new Date(Date.parse(row[1]) + copy * 60 * 1000).toISOString();
+      extra[4] = new Date(Date.parse(row[4]) + copy * 60 * 1000).toISOString();
+      rows.push(extra);
+    });
+  }
+  return rows.sort(function(a, b) {
+    return Date.parse(a[4]) - Date.parse(b[4]);
+  });
+}
+
+function board(stationId) {
+  var recorded = boards[stationId];
+  if (!recorded && !options.strict) {
+    recorded = boards[smallestBoard];
+  }
+  return recorded ? scaled(rebase(recorded)) : null;
+}
+
+// fields=0,2,3,4,5 picks columns of the departure rows
+function departureFields(departures, query) {
+  if (!query.fields) {
+    return departures;
+  }
+  var columns = query.fields.split(',').map(Number);
+  return departures.map(function(row) {
+    return columns.map(function(column) {
+      return row[column];
+    });
+  });
+}
+
+// Lines without recorded stops go from here to another recorded station,
+// so jumping to a stop always has a board to show
+function fallbackStops(stationId, destination) {
+  var next = Object.keys(boards).filter(function(id) {
+    return id != stationId;
+  })[0] || stationId;
+  return [[stationId, 'Haltestelle ' + stationId], [parseInt(next, 10), destination]];
+}
+
+function moreInfo(stationId, tripId, query) {
+  var departures = board(stationId) || [];
+  var row = departures.filter(function(departure) {
+    return departure[0] == tripId;
+  })[0];
+  // the train has left, the real server answers the same
+  if (!row) {
+    return null;
+  }
+  var line = row[2];
+  var type = /^(STR|Tram)/.test(line) ? 'TRAM' : /^Bus/.test(line) ? 'BUS' : 'TRAIN';
+  var info = {
+    lineName: line,
+    destination: row[3],
+    platform: row[5],
+    timeDelayed: row[4],
+    timeSchedule: row[1],
+    type: type,
+    stops: stops[line] || fallbackStops(stationId, row[3])
+  };
+  if (!query.fields) {
+    return info;
+  }
+  var picked = {};
+  query.fields.split(',').forEach(function(field) {
+    picked[field] = info[field];
+  });
+  return picked;
+}
+
+function route(pathname, query) {
+  var match;
+  if (pathname == '/pebble/stations') {
+    return stations;
+  }
+  if (pathname == '/pebble/currentLocation') {
+    var nearest = stations[0];
+    var departures = board(parseInt(nearest[2], 10));
+    return departures && {station: nearest, departures: departureFields(departures, query)};
+  }
+  if ((match = /^\/pebble\/current\/(\d+)$/.exec(pathname))) {
+    var rows = board(parseInt(match[1], 10));
+    return rows && departureFields(rows, query);
+  }
+  if ((match = /^\/pebble\/moreinfo\/(\d+)\/(.+)$/.exec(pathname))) {
+    return moreInfo(parseInt(match[1], 10), decodeURIComponent(match[2]), query);
+  }
+  return null;
+}
+
+function injects(pathname, rate) {
+  return rate > 0 && pathname.indexOf(options.only) >= 0 && Math.random() < rate;
+}
+
+http.createServer(function(req, res) {
+  var started = Date.now();
+  var parsed = url.parse(req.url, true);
+  var delay = options.latency + Math.random() * options.jitter;
+
+  function log(status, bytes) {
+    console.log(`${new Date().toISOString()} ${status} ${req.url} ${bytes} B ${Date.now() - started} ms`);
+  }
+
+  if (injects(parsed.pathname, options.timeout)) {
+    log('timeout', 0);
+    // long after any client has given up
+    setTimeout(function() {
+      req.socket.destroy();
+    }, 120 * 1000);
+    return;
+  }
+  setTimeout(function() {
+    var body = injects(parsed.pathname, options["not-found"]) ? null : route(parsed.pathname, parsed.query);
+    if (body == null) {
+      res.writeHead(404, {'Content-Type': 'text/plain'});
+      res.end('Not Found');
+      log(404, 0);
+      return;
+    }
+    var json = JSON.stringify(body);
+    var etag = '"' + crypto.createHash('sha1').update(json).digest('hex').slice(0, 16) + '"';
+    if (req.headers['if-none-match'] == etag) {
+      res.writeHead(304, {'ETag': etag});
+      res.end();
+      log(304, 0);
+      return;
+    }
+    res.writeHead(200, {'Content-Type': 'application/json; charset=utf-8', 'ETag': etag});
+    res.end(json);
+    log(200, Buffer.byteLength(json));
+  }, delay);
+}).listen(options.port, function() {
+  console.log(`mock bahnhof-server on port ${options.port} with ${Object.keys(boards).length} boards`);
+});